@@ -0,0 +1,126 @@
+#define SDL_MAIN_HANDLED
+#include "../src/engine/custom/MyEngineSystem.h"										// For MyEngineSystem
+#include <unordered_map>																// For the original tag storage
+#include <random>																		// For pair generation
+#include <chrono>																		// For timing
+#include <cstdio>																		// For printf
+#include <vector>																		// For entities and pairs
+
+/**
+* Compares the cost of classifying colliding pairs when the entity tag comes from probing
+* six tag stores (the original getEntityTag) against MyEngineSystem's own signature tags
+* and collision response table, then times the same pairs through collectContactPairs
+* and processCollisionEntities in steps of STEP_PAIRS contacts
+*/
+
+enum Action { NONE = 0, END_LEVEL, AMMO_PICKUP, HEALTH_PICKUP, PROJECTILE_HIT, NPC_HIT };	// Dispatch result
+static constexpr int PAIRS = { 1 << 20 };												// Pairs classified per run
+static constexpr int STEP_PAIRS = { 256 };												// Pairs resolved per simulated step
+
+class CollisionDispatchBench {
+public:
+	static int run();
+private:
+	using Entity = MyEngineSystem::Entity;												// Entity type
+	using EntityTag = MyEngineSystem::EntityTag;										// Entity tag type
+	template<typename TagOf>
+	static Action dispatchByTag(Entity primary, Entity other, TagOf tagOf);
+	static Action dispatchByTable(MyEngineSystem& sys, Entity primary, Entity other);
+};
+
+template<typename TagOf>
+Action CollisionDispatchBench::dispatchByTag(Entity primary, Entity other, TagOf tagOf)	// original processCollisionEntities decision chain on getEntityTag
+{
+	if ((tagOf(primary) == EntityTag::ENDLEVEL && tagOf(other) == EntityTag::PC)
+		|| (tagOf(other) == EntityTag::ENDLEVEL && tagOf(primary) == EntityTag::PC)) return END_LEVEL;
+	if (tagOf(primary) == EntityTag::AMMO || tagOf(other) == EntityTag::AMMO) return AMMO_PICKUP;
+	if ((tagOf(primary) == EntityTag::HEALTH && tagOf(other) == EntityTag::NPC)
+		|| (tagOf(primary) == EntityTag::NPC && tagOf(other) == EntityTag::HEALTH)) return NONE;
+	if (tagOf(primary) == EntityTag::HEALTH || tagOf(other) == EntityTag::HEALTH) return HEALTH_PICKUP;
+	if (tagOf(primary) == EntityTag::PROJECTILE || tagOf(other) == EntityTag::PROJECTILE) return PROJECTILE_HIT;
+	if ((tagOf(primary) == EntityTag::NPC && tagOf(other) == EntityTag::PC)
+		|| (tagOf(other) == EntityTag::NPC && tagOf(primary) == EntityTag::PC)) return NPC_HIT;
+	return NONE;
+}
+
+Action CollisionDispatchBench::dispatchByTable(MyEngineSystem& sys, Entity primary, Entity other)	// response the engine's table picks, as an Action
+{
+	const MyEngineSystem::CollisionResponse& response = sys.collisionResponses[int(sys.getEntityTag(primary))][int(sys.getEntityTag(other))];
+	if (!response.handler) return NONE;
+	if (response.handler == &MyEngineSystem::onEndLevelReached) return END_LEVEL;
+	if (response.handler == &MyEngineSystem::increaseAmmo) return AMMO_PICKUP;
+	if (response.handler == &MyEngineSystem::onHealthPickup) return HEALTH_PICKUP;
+	return sys.hasAnyOf(primary, MyEngineSystem::PROJECTILE_BIT) || sys.hasAnyOf(other, MyEngineSystem::PROJECTILE_BIT) ? PROJECTILE_HIT : NPC_HIT;
+}
+
+template<typename Run>
+double timeRun(Run run, int& checksum)
+{
+	auto start = std::chrono::high_resolution_clock::now();							// start time
+	checksum = run();																	// classify all pairs
+	auto end = std::chrono::high_resolution_clock::now();								// end time
+	return std::chrono::duration<double, std::nano>(end - start).count() / PAIRS;		// nanoseconds per pair
+}
+
+int CollisionDispatchBench::run()
+{
+	const int counts[] = { 1000, 10000, 100000 };									// entity counts to test
+	std::printf("%10s %16s %16s %16s\n", "entities", "map tags ns", "engine table ns", "process ns");
+	for (int count : counts) {														// FOR EACH ENTITY COUNT
+		MyEngineSystem sys;															// engine with its own response table, no components beyond tags
+		std::unordered_map<Entity, EntityTag> mapTags[6];							// original per-tag maps, in getEntityTag probe order
+		std::vector<Entity> entities;												// live entities, the first is the player
+		std::mt19937 rng(1234);														// fixed seed so all runs see the same world
+		for (int i = 0; i < count; ++i) {											// FOR EACH ENTITY, mostly NPCs and projectiles like a level
+			Entity e = sys.createEntity();
+			int roll = int(rng() % 100);
+			int tag = (i == 0) ? 0 : (roll < 45) ? 1 : (roll < 85) ? 4 : (roll < 93) ? 2 : (roll < 99) ? 3 : 5;
+			switch (tag) {															// same tag through the engine's setters
+			case 0: sys.addComponentPCTag(e); break;
+			case 1: sys.addComponentNPCTag(e); break;
+			case 2: sys.addComponentAmmoPickupTag(e); break;
+			case 3: sys.addComponentHealthPickupTag(e); break;
+			case 4: sys.addComponentProjectileTag(e, entities.front()); break;
+			default: sys.addComponentEndLevelTag(e); break;
+			}
+			mapTags[tag][e] = EntityTag(tag + 1); entities.push_back(e);
+		}
+		std::vector<std::pair<Entity, Entity>> pairs(PAIRS);						// colliding pairs, one side is often the player
+		for (auto& pair : pairs) pair = { entities[(rng() % 4 == 0) ? 0 : rng() % count], entities[rng() % count] };
+		auto mapTag = [&](Entity e) {												// getEntityTag over unordered_maps
+			for (int t = 0; t < 6; ++t) if (mapTags[t].find(e) != mapTags[t].end()) return EntityTag(t + 1);
+			return EntityTag::Unknown;
+		};
+		for (auto& p : pairs) if (dispatchByTag(p.first, p.second, mapTag) != dispatchByTable(sys, p.first, p.second)) {	// IF TABLE DISAGREES WITH THE ORIGINAL CHAIN
+			std::printf("dispatch results differ\n"); return 1;
+		}
+		int mapSum = 0, tableSum = 0, processSum = 0;								// checksums, also keep the work alive
+		double mapTime = timeRun([&] { int sum = 0; for (auto& p : pairs) sum += dispatchByTag(p.first, p.second, mapTag) != NONE; return sum; }, mapSum);
+		double tableTime = timeRun([&] {											// tag from the signature, response from the table
+			int sum = 0;
+			for (auto& p : pairs) sum += sys.collisionResponses[int(sys.getEntityTag(p.first))][int(sys.getEntityTag(p.second))].handler != nullptr;
+			return sum;
+		}, tableSum);
+		sys.collisionChunks.resize(1);												// one contact buffer, refilled per step
+		double processTime = timeRun([&] {											// resolve every pair, STEP_PAIRS contacts per step like collisionSystem
+			int sum = 0;
+			for (int step = 0; step < PAIRS; step += STEP_PAIRS) {
+				std::vector<MyEngineSystem::CollisionContact>& contacts = sys.collisionChunks[0].contacts;
+				contacts.clear();
+				for (int i = step; i < step + STEP_PAIRS; ++i) contacts.push_back({ pairs[i].first, pairs[i].second });
+				sys.collectContactPairs();
+				for (const MyEngineSystem::CollisionContact& contact : contacts) sys.processCollisionEntities(contact.primary, contact.other);
+				sum += int(sys.contactPairs.size());
+			}
+			return sum;
+		}, processSum);
+		if (mapSum != tableSum) { std::printf("dispatch results differ\n"); return 1; }
+		std::printf("%10d %16.2f %16.2f %16.2f\n", count, mapTime, tableTime, processTime);
+	}
+	return 0;
+}
+
+int main()
+{
+	return CollisionDispatchBench::run();
+}
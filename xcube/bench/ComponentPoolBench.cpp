@@ -0,0 +1,72 @@
+#include "../src/engine/custom/ComponentPool.h"											// For ComponentPool
+#include <unordered_map>																// For the previous storage
+#include <chrono>																		// For timing
+#include <cstdio>																		// For printf
+
+/**
+* Compares the per-frame cost of the movement/collision style loop
+* (iterate one component, look up two others on the same entity)
+* between std::unordered_map storage and ComponentPool storage
+*/
+
+using Entity = std::uint32_t;															// Entity type
+struct Transform { float x = {}, y = {}, newX = {}, newY = {}; bool active = true; };	// Transform stand-in
+struct Velocity { float x = {}, y = {}; };												// Velocity stand-in
+struct Collider { int x = {}, y = {}, w = 16, h = 16; };								// Collider stand-in
+static constexpr float deltaTime = { 1.0f / 60.0f };									// Fixed frame delta
+static constexpr int FRAMES = { 200 };													// Frames timed per run
+
+template<typename TransformStore, typename VelocityStore, typename ColliderStore, typename Frame>
+double timeFrames(TransformStore& transforms, VelocityStore& velocities, ColliderStore& colliders, Frame frame)
+{
+	auto start = std::chrono::high_resolution_clock::now();								// start time
+	for (int i = 0; i < FRAMES; ++i) frame(transforms, velocities, colliders);			// run frames
+	auto end = std::chrono::high_resolution_clock::now();								// end time
+	return std::chrono::duration<double, std::micro>(end - start).count() / FRAMES;		// microseconds per frame
+}
+
+int main()
+{
+	const Entity counts[] = { 1000, 10000, 100000 };								// entity counts to test
+	std::printf("%10s %18s %18s %10s\n", "entities", "unordered_map us", "ComponentPool us", "speedup");
+	for (Entity count : counts) {													// FOR EACH ENTITY COUNT
+		std::unordered_map<Entity, Transform> mapTransforms;						// previous storage
+		std::unordered_map<Entity, Velocity> mapVelocities;
+		std::unordered_map<Entity, Collider> mapColliders;
+		ComponentPool<Transform> poolTransforms;									// sparse set storage
+		ComponentPool<Velocity> poolVelocities;
+		ComponentPool<Collider> poolColliders;
+		for (Entity e = 0; e < count; ++e) {										// FOR EACH ENTITY, same components in both stores
+			Transform transform; transform.x = float(e % 1024); transform.y = float(e / 1024);
+			mapTransforms[e] = transform; poolTransforms.insert(e, transform);
+			mapColliders[e] = Collider{}; poolColliders.insert(e, Collider{});
+			if (e % 4 == 0) continue;												// a quarter of entities do not move, like walls and pickups
+			mapVelocities[e] = Velocity{ 1.0f, -1.0f }; poolVelocities.insert(e, Velocity{ 1.0f, -1.0f });
+		}
+		double mapTime = timeFrames(mapTransforms, mapVelocities, mapColliders, [](std::unordered_map<Entity, Transform>& transforms, std::unordered_map<Entity, Velocity>& velocities, std::unordered_map<Entity, Collider>& colliders) {
+			for (auto& velocityComp : velocities) {									// FOR EACH VELOCITY, as the systems did before
+				Entity entity = velocityComp.first;
+				if (transforms.find(entity) == transforms.end()) continue;			// isValidComponent probe
+				if (colliders.find(entity) == colliders.end()) continue;			// isValidComponent probe
+				Transform& transform = transforms[entity];							// second probe
+				if (!transform.active) continue;
+				transform.newX = transform.x + velocityComp.second.x * deltaTime;
+				transform.newY = transform.y + velocityComp.second.y * deltaTime;
+				Collider& collider = colliders[entity];								// second probe
+				collider.x = int(transform.newX); collider.y = int(transform.newY);
+			}
+		});
+		double poolTime = timeFrames(poolTransforms, poolVelocities, poolColliders, [](ComponentPool<Transform>& transforms, ComponentPool<Velocity>& velocities, ComponentPool<Collider>& colliders) {
+			for (auto velocityComp : velocities) {									// FOR EACH VELOCITY, packed iteration
+				Transform* transform = transforms.find(velocityComp.first);			// single index
+				Collider* collider = colliders.find(velocityComp.first);			// single index
+				if (!transform || !collider || !transform->active) continue;
+				transform->newX = transform->x + velocityComp.second.x * deltaTime;
+				transform->newY = transform->y + velocityComp.second.y * deltaTime;
+				collider->x = int(transform->newX); collider->y = int(transform->newY);
+			}
+		});
+		std::printf("%10u %18.1f %18.1f %9.2fx\n", count, mapTime, poolTime, mapTime / poolTime);
+	}
+	return 0;
+}
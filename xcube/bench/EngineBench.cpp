@@ -0,0 +1,300 @@
+#define SDL_MAIN_HANDLED
+#include "../src/engine/XCube2d.h"																			// For XCube2Engine, GraphicsEngine and MyEngineSystem
+#include <algorithm>																						// For sort
+#include <random>																							// For world generation
+#include <chrono>																							// For timing
+#include <cmath>																							// For sqrt, sin and cos
+#include <cstdio>																							// For printf and the JSON file
+#include <cstdlib>																							// For atoi
+#include <cstring>																							// For strcmp
+#include <string>																							// For system names
+#include <vector>																							// For samples
+
+/**
+* Times each MyEngineSystem system on its own against synthetic worlds, without the demo
+*
+* usage: EngineBench [-f frames] [-o output.json] [npcs walls projectiles]...
+*
+* Every scenario builds a fresh MyEngineSystem with N NPCs chasing one player, M walls
+* and P projectiles in flight, then steps it the way update() does without a job graph, timing
+* aiSystem, movementSystem, collisionSystem, animationSystem (with updateAnimationStates),
+* render and flushDestroyedEntities separately. The parallel systems still spread their chunks
+* over the engine's job workers, the JSON records how many there were. Projectiles that hit something are fired again
+* and NPCs that die are respawned between frames, so every frame sees the same world size.
+* Rendering goes through SDL's dummy video driver and the software renderer, so no GPU or display
+* is needed. SDL rasterises every batch render() submits on the CPU inside the timed call,
+* so the render numbers are software renderer timings, not the cost of submission alone.
+* Results are printed as a table and written as JSON (engine_bench.json by default)
+*/
+
+static constexpr float STEP = { 1.0f / 60.0f };																// Fixed timestep, same as AbstractGame
+static constexpr int DEFAULT_FRAMES = { 300 };																// Frames stepped per scenario
+static constexpr int WARMUP_FRAMES = { 30 };																// Frames stepped before timing starts
+static constexpr int SHEET_SIZE = { 64 };																	// Generated sprite sheet, 4x4 frames of TILE_SIZE
+static const char* RENDER_DRIVER = "software";																// SDL renderer behind the render timings, recorded in the JSON
+
+enum BenchSystem { AI = 0, MOVEMENT, COLLISION, ANIMATION, RENDER, FLUSH, SYSTEM_COUNT };					// Systems timed, in update() order
+static const char* SYSTEM_NAMES[SYSTEM_COUNT] = { "aiSystem", "movementSystem", "collisionSystem",
+	"animationSystem", "render", "flushDestroyedEntities" };
+
+struct Scenario { int npcs, walls, projectiles; };															// World to build
+struct SystemStats { double mean, p50, p95, max; };															// Microseconds per frame
+struct ScenarioResult { Scenario scenario; int worldTiles, entities; SystemStats systems[SYSTEM_COUNT]; };	// One scenario measured
+
+class EngineBench {
+public:
+	static ScenarioResult run(const Scenario& scenario, int frames, std::shared_ptr<GraphicsEngine> gfx, std::shared_ptr<JobSystem> jobs, SDL_Texture* sheet);
+private:
+	using Entity = MyEngineSystem::Entity;																	// Entity type
+	static void addSprites(MyEngineSystem& sys, SDL_Texture* sheet);
+	static Entity spawnPlayer(MyEngineSystem& sys, float x, float y, int projectiles);
+	static Entity spawnNPC(MyEngineSystem& sys, float x, float y);
+	static Vector2f freeCell(MyEngineSystem& sys, int worldTiles, std::mt19937& rng);
+	static void refireProjectiles(MyEngineSystem& sys, Entity player, int worldTiles, std::mt19937& rng);
+};
+
+void EngineBench::addSprites(MyEngineSystem& sys, SDL_Texture* sheet)
+{
+	MyEngineSystem::SpriteSource source = { "", SDL_Color{ 255, 255, 255, 255 }, false };			// Generated, not from a file
+	const char* units[] = { "zombie", "player" };													// Animated sheets, rows of 4 frames
+	const char* directions[] = { "down", "right", "up" };
+	for (const char* unit : units) {
+		for (const char* direction : directions) {
+			std::string suffix = std::string("_") + direction;
+			sys.addSprite(std::string(unit) + "_idle" + suffix, sheet, MyEngineSystem::makeSprite(TILE_SIZE, TILE_SIZE, 4, 0, true, DEFAULT_ENTITY_SCALE), source);
+			sys.addSprite(std::string(unit) + "_walk" + suffix, sheet, MyEngineSystem::makeSprite(TILE_SIZE, TILE_SIZE, 4, 4, true, DEFAULT_ENTITY_SCALE), source);
+			sys.addSprite(std::string(unit) + "_death" + suffix, sheet, MyEngineSystem::makeSprite(TILE_SIZE, TILE_SIZE, 4, 8, false, DEFAULT_ENTITY_SCALE), source);
+		}
+	}
+	sys.addSprite("bullet", sheet, MyEngineSystem::makeSprite(TILE_SIZE / 2, TILE_SIZE / 2, 1, 0, true, DEFAULT_ENTITY_SCALE), source);
+	sys.addSprite("block", sheet, MyEngineSystem::makeSprite(TILE_SIZE, TILE_SIZE, 1, 12, true, DEFAULT_ENTITY_SCALE), source);
+}
+
+EngineBench::Entity EngineBench::spawnPlayer(MyEngineSystem& sys, float x, float y, int projectiles)
+{
+	Entity entity = sys.createEntity();																// Same components as MyGame::spawnPC,
+	sys.addComponentPCTag(entity);																	// less health so NPCs cannot end the run
+	sys.addComponentTransform(entity, Vector2f(x, y), 1, 0, OBJECT_LAYER);							// and less audio, there are no sounds loaded
+	sys.addComponentVelocity(entity);
+	sys.addComponentSpeed(entity, DEFAULT_PC_SPEED);
+	sys.addComponentCollider(entity, x, y, TILE_SIZE, TILE_SIZE);
+	sys.addComponentAmmo(entity, projectiles, projectiles);
+	sys.addComponentDamage(entity, 25);
+	sys.addComponentInput(entity);
+	sys.addComponentIdleAnimations(entity, "player_idle_down", "player_idle_right", "player_idle_up");
+	sys.addComponentWalkAnimations(entity, "player_walk_down", "player_walk_right", "player_walk_up");
+	sys.attachSprite(entity, "player_idle_down");
+	sys.initProjectilePool(entity, size_t(projectiles));
+	return entity;
+}
+
+EngineBench::Entity EngineBench::spawnNPC(MyEngineSystem& sys, float x, float y)
+{
+	Entity entity = sys.createEntity();																// Same components as MyGame::spawnNPC, less audio
+	sys.addComponentNPCTag(entity);
+	sys.addComponentTransform(entity, Vector2f(x, y), 1, 0, OBJECT_LAYER, true);
+	sys.addComponentVelocity(entity);
+	sys.addComponentSpeed(entity, DEFAULT_UNIT_SPEED);
+	sys.addComponentCollider(entity, x, y, TILE_SIZE, TILE_SIZE);
+	sys.addComponentHealth(entity, DEFAULT_MAX_HEALTH / 2, DEFAULT_MAX_HEALTH);
+	sys.addComponentHealthBar(entity);
+	sys.addComponentDamage(entity, DEFAULT_UNIT_DAMAGE);
+	sys.addComponentDying(entity);
+	sys.addComponentIdleAnimations(entity, "zombie_idle_down", "zombie_idle_right", "zombie_idle_up");
+	sys.addComponentWalkAnimations(entity, "zombie_walk_down", "zombie_walk_right", "zombie_walk_up");
+	sys.addComponentDeathAnimations(entity, "zombie_death_down", "zombie_death_right", "zombie_death_up");
+	sys.attachSprite(entity, "zombie_idle_down");
+	sys.addComponentScoreValue(entity, 10);
+	return entity;
+}
+
+Vector2f EngineBench::freeCell(MyEngineSystem& sys, int worldTiles, std::mt19937& rng)
+{
+	std::uniform_int_distribution<int> cell(1, worldTiles - 2);										// Keep off the world edge
+	for (int attempt = 0; attempt < 64; ++attempt) {
+		int col = cell(rng), row = cell(rng);
+		if (!sys.staticTiles.isSolid(col, row))														// IF NOT A WALL, use it
+			return Vector2f(float(col * int(TILE_SIZE)), float(row * int(TILE_SIZE)));
+	}
+	return Vector2f(float(TILE_SIZE), float(TILE_SIZE));
+}
+
+void EngineBench::refireProjectiles(MyEngineSystem& sys, Entity player, int worldTiles, std::mt19937& rng)
+{
+	std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);												// Random heading
+	MyEngineSystem::Ammo& ammo = sys.component.ammos[player];
+	for (Entity projectile : sys.projectilePools[player]) {
+		if (sys.component.transforms[projectile].active) continue;												// IF STILL IN FLIGHT, skip
+		ammo.currentAmmo = ammo.maxAmmo;																		// fireProjectile is rate limited
+		ammo.lastFireTime = sys.now - STAT_CHANGE_COOLDOWN;														// and needs ammo, satisfy both
+		Vector2f start = freeCell(sys, worldTiles, rng);
+		float heading = angle(rng);
+		sys.fireProjectile(player, start, Vector2f(start.x + std::cos(heading), start.y + std::sin(heading)));	// fires the first inactive projectile, this one
+	}
+}
+
+static SystemStats summarise(std::vector<double>& samples)
+{
+	SystemStats stats = {};
+	if (samples.empty()) return stats;
+	std::sort(samples.begin(), samples.end());
+	for (double sample : samples) stats.mean += sample;
+	stats.mean /= double(samples.size());
+	stats.p50 = getPercentile(samples, 0.50);														// Nearest rank, as GraphicsEngine::getFrameTimeStats
+	stats.p95 = getPercentile(samples, 0.95);
+	stats.max = samples.back();
+	return stats;
+}
+
+ScenarioResult EngineBench::run(const Scenario& scenario, int frames, std::shared_ptr<GraphicsEngine> gfx, std::shared_ptr<JobSystem> jobs, SDL_Texture* sheet)
+{
+	ScenarioResult result = {};
+	result.scenario = scenario;
+	int occupied = scenario.npcs + scenario.walls + scenario.projectiles;							// One entity per 8 cells on average,
+	result.worldTiles = std::max(64, int(std::sqrt(double(occupied) * 8.0)));						// dense enough for NPCs to meet walls and bullets
+
+	std::unique_ptr<MyEngineSystem> system(new MyEngineSystem());									// Fresh system, nothing left from the last scenario
+	MyEngineSystem& sys = *system;
+	sys.jobs = jobs;																				// Parallel systems spread over the engine's workers
+	std::mt19937 rng(12345);																		// Fixed seed, every run builds the same world
+	Uint32 worldSize = Uint32(result.worldTiles) * TILE_SIZE;
+	sys.setWorldDimensions(worldSize, worldSize);
+	addSprites(sys, sheet);
+
+	std::uniform_int_distribution<int> cell(1, result.worldTiles - 2);
+	for (int i = 0; i < scenario.walls; ++i)
+		sys.addStaticTile("block", cell(rng) * int(TILE_SIZE), cell(rng) * int(TILE_SIZE));
+	float centre = float(worldSize / 2);
+	Entity player = spawnPlayer(sys, centre, centre, std::max(1, scenario.projectiles));
+	for (int i = 0; i < scenario.npcs; ++i) {
+		Vector2f position = freeCell(sys, result.worldTiles, rng);
+		spawnNPC(sys, position.x, position.y);
+	}
+
+	std::vector<double> samples[SYSTEM_COUNT];
+	for (std::vector<double>& systemSamples : samples) systemSamples.reserve(size_t(frames));
+	auto time = [](std::vector<double>* out, auto call) {											// Run call, keep its time in microseconds
+		auto start = std::chrono::high_resolution_clock::now();
+		call();
+		auto end = std::chrono::high_resolution_clock::now();
+		if (out) out->push_back(std::chrono::duration<double, std::micro>(end - start).count());
+	};
+
+	sys.simulatedTime = 1.0;																		// Start past the stat change cooldowns
+	for (int frame = 0; frame < WARMUP_FRAMES + frames; ++frame) {
+		bool timed = frame >= WARMUP_FRAMES;
+		sys.simulatedTime += STEP;
+		sys.now = Uint32(sys.simulatedTime * 1000.0);												// Simulated clock, the same on every machine
+		if (scenario.projectiles > 0) refireProjectiles(sys, player, result.worldTiles, rng);		// Keep every projectile in flight
+		for (MyEngineSystem::Transform& transform : sys.component.transforms.components()) transform.previousPosition = transform.position;
+
+		std::vector<double> animationParts;															// animationSystem and updateAnimationStates run apart
+		time(timed ? &samples[AI] : nullptr, [&] { sys.aiSystem(sys.component, player, STEP); });
+		time(&animationParts, [&] { sys.animationSystem(sys.component, STEP); });
+		time(timed ? &samples[MOVEMENT] : nullptr, [&] { sys.movementSystem(sys.component, STEP); });
+		time(timed ? &samples[COLLISION] : nullptr, [&] { sys.collisionSystem(sys.component, STEP); });
+		time(&animationParts, [&] { sys.updateAnimationStates(sys.component, STEP); });
+		if (timed) samples[ANIMATION].push_back(animationParts[0] + animationParts[1]);
+		sys.processPendingDeaths();
+		time(timed ? &samples[FLUSH] : nullptr, [&] { sys.flushDestroyedEntities(); });
+
+		gfx->clearScreen();
+		time(timed ? &samples[RENDER] : nullptr, [&] { sys.render(gfx, 1.0f, STEP); });
+		gfx->showScreen();																			// Dummy driver, presents nowhere
+
+		for (int npc = sys.getNPCCount(); npc < scenario.npcs; ++npc) {								// Respawn NPCs that died, same world size every frame
+			Vector2f position = freeCell(sys, result.worldTiles, rng);
+			spawnNPC(sys, position.x, position.y);
+		}
+	}
+
+	result.entities = int(sys.component.transforms.size());
+	for (int s = 0; s < SYSTEM_COUNT; ++s)
+		result.systems[s] = summarise(samples[s]);
+	return result;
+}
+
+static bool writeJson(const char* file, int frames, int workers, const std::vector<ScenarioResult>& results)
+{
+	FILE* out = std::fopen(file, "w");
+	if (nullptr == out) return false;
+	std::fprintf(out, "{\n  \"benchmark\": \"EngineBench\",\n  \"unit\": \"us\",\n  \"frames\": %d,\n  \"workers\": %d,\n  \"renderer\": \"%s\",\n  \"deltaTime\": %.6f,\n  \"scenarios\": [\n", frames, workers, RENDER_DRIVER, STEP);
+	for (size_t i = 0; i < results.size(); ++i) {
+		const ScenarioResult& result = results[i];
+		std::fprintf(out, "    {\n      \"npcs\": %d,\n      \"walls\": %d,\n      \"projectiles\": %d,\n      \"worldTiles\": %d,\n      \"entities\": %d,\n      \"systems\": {\n",
+			result.scenario.npcs, result.scenario.walls, result.scenario.projectiles, result.worldTiles, result.entities);
+		for (int s = 0; s < SYSTEM_COUNT; ++s) {
+			const SystemStats& stats = result.systems[s];
+			std::fprintf(out, "        \"%s\": { \"mean\": %.3f, \"p50\": %.3f, \"p95\": %.3f, \"max\": %.3f }%s\n",
+				SYSTEM_NAMES[s], stats.mean, stats.p50, stats.p95, stats.max, s + 1 < SYSTEM_COUNT ? "," : "");
+		}
+		std::fprintf(out, "      }\n    }%s\n", i + 1 < results.size() ? "," : "");
+	}
+	std::fprintf(out, "  ]\n}\n");
+	return std::fclose(out) == 0;
+}
+
+int main(int argc, char* argv[])
+{
+	int frames = DEFAULT_FRAMES;
+	const char* output = "engine_bench.json";
+	std::vector<Scenario> scenarios;
+	for (int arg = 1; arg < argc; ++arg) {
+		if (std::strcmp(argv[arg], "-f") == 0 && arg + 1 < argc) frames = std::atoi(argv[++arg]);
+		else if (std::strcmp(argv[arg], "-o") == 0 && arg + 1 < argc) output = argv[++arg];
+		else if (arg + 2 < argc) {
+			scenarios.push_back(Scenario{ std::atoi(argv[arg]), std::atoi(argv[arg + 1]), std::atoi(argv[arg + 2]) });
+			arg += 2;
+		}
+		else {
+			std::printf("usage: EngineBench [-f frames] [-o output.json] [npcs walls projectiles]...\n");
+			return 1;
+		}
+	}
+	if (frames <= 0) frames = DEFAULT_FRAMES;
+	if (scenarios.empty())																			// Demo sized, busy and stress worlds
+		scenarios = { Scenario{ 20, 400, 50 }, Scenario{ 500, 4000, 500 }, Scenario{ 5000, 20000, 2000 } };
+
+	SDL_setenv("SDL_VIDEODRIVER", "dummy", 1);														// No display, no GPU
+	SDL_setenv("SDL_AUDIODRIVER", "dummy", 1);														// AudioEngine still opens a device
+	SDL_SetHint(SDL_HINT_RENDER_DRIVER, RENDER_DRIVER);												// Picked by name, so the accelerated flag is not required
+
+	std::vector<ScenarioResult> results;
+	int workers = 0;
+	try {
+		std::shared_ptr<XCube2Engine> engine = XCube2Engine::getInstance();
+		std::shared_ptr<GraphicsEngine> gfx = engine->getGraphicsEngine();
+		workers = engine->getJobSystem()->getWorkerCount();
+
+		SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, SHEET_SIZE, SHEET_SIZE, 32, SDL_PIXELFORMAT_RGBA32);
+		if (nullptr == surface)
+			throw EngineException("Failed to create sprite sheet", SDL_GetError());
+		SDL_FillRect(surface, nullptr, SDL_MapRGBA(surface->format, 200, 80, 80, 255));
+		SDL_Texture* sheet = GraphicsEngine::createTextureFromSurface(surface);
+		SDL_FreeSurface(surface);
+
+		std::printf("\n%8s %8s %8s | %10s %10s %10s %10s %10s %10s   (mean us per frame, render on the %s renderer)\n", "npcs", "walls", "proj",
+			"ai", "movement", "collision", "animation", "render", "flush", RENDER_DRIVER);
+		for (const Scenario& scenario : scenarios) {
+			ScenarioResult result = EngineBench::run(scenario, frames, gfx, engine->getJobSystem(), sheet);
+			std::printf("%8d %8d %8d | %10.2f %10.2f %10.2f %10.2f %10.2f %10.2f\n", scenario.npcs, scenario.walls, scenario.projectiles,
+				result.systems[AI].mean, result.systems[MOVEMENT].mean, result.systems[COLLISION].mean,
+				result.systems[ANIMATION].mean, result.systems[RENDER].mean, result.systems[FLUSH].mean);
+			results.push_back(result);
+		}
+
+		SDL_DestroyTexture(sheet);
+		engine.reset();
+		XCube2Engine::quit();
+	} catch (EngineException& e) {
+		std::printf("%s\n", e.what());
+		return 1;
+	}
+
+	if (!writeJson(output, frames, workers, results)) {
+		std::printf("Failed to write %s\n", output);
+		return 1;
+	}
+	std::printf("\nResults written to %s\n", output);
+	return 0;
+}
@@ -1,14 +1,40 @@
 #include "MyGame.h"
 
+#include <cstring>
+#include <cstdlib>
+
 int main(int argc, char * args[]) {
+	// --headless <steps> simulates that many updates without a window, as fast as possible, then exits
+	// --trace <file> writes a Chrome trace of the profiler zones, debug builds only
+	Uint64 headlessSteps = 0;
+	const char * traceFile = nullptr;
+	for (int i = 1; i + 1 < argc; ++i) {
+		if (std::strcmp(args[i], "--headless") == 0)
+			headlessSteps = std::strtoull(args[i + 1], nullptr, 10);
+		else if (std::strcmp(args[i], "--trace") == 0)
+			traceFile = args[i + 1];
+	}
+
+#ifdef __PROFILE
+	if (traceFile)
+		Profiler::startTrace(traceFile);
+#endif
 
 	try {
+		if (headlessSteps > 0)
+			XCube2Engine::setHeadless(true);
+
         MyGame game;
-		game.runMainLoop();
+		if (headlessSteps > 0)
+			game.runHeadless(headlessSteps);
+		else
+			game.runMainLoop();
 	} catch (EngineException & e) {
 		std::cout << e.what() << std::endl;
-		getchar();
+		if (0 == headlessSteps)
+			getchar();
+		return 1;
 	}
 
 	return 0;
-}
\ No newline at end of file
+}
@@ -1,17 +1,24 @@
 #include "MyGame.h"
 
 MyGame::MyGame() : AbstractGame(), numAmmo(5), numHealth(3), gameWon(false) {
-	srand((unsigned int)time(nullptr));																				// Seed random number generator
-	font = ResourceManager::loadFont("res/fonts/arial.ttf", DEFAULT_FONT_SIZE);										// Load font
-	gfx->useFont(font);																								// Use font
-	gfx->setVerticalSync(true);																						// Enable VSync
-	gfx->setWindowFocus();																							// Set window focus
-	gfx->setWindowResizable();																						// Make window resizable
-	gfx->setWindowTitle("CI517 - Chad Nippard");																	// Set window title
+	srand(XCube2Engine::isHeadless() ? 0u : (unsigned int)time(nullptr));											// Seed random number generator, fixed when headless so runs repeat exactly
+	if (gfx) {																										// IF NOT HEADLESS, set up font and window
+		font = ResourceManager::loadFont("res/fonts/arial.ttf", DEFAULT_FONT_SIZE);									// Load font
+		gfx->useFont(font);																							// Use font
+		npcLabel.setColor(SDL_COLOR_RED); healthLabel.setColor(SDL_COLOR_GREEN); ammoLabel.setColor(SDL_COLOR_ORANGE);	// HUD label colours, score and draw calls stay white
+		wonLabel.setText("YOU WON"); wonLabel.setColor(SDL_COLOR_ORANGE);											// win message never changes
+		gfx->setVerticalSync(true);																					// Enable VSync
+		gfx->setWindowFocus();																						// Set window focus
+		gfx->setWindowResizable();																					// Make window resizable
+		gfx->setWindowTitle("CI517 - Chad Nippard");																// Set window title
+	}
 	mySystem->setWorldDimensions(worldWidth, worldHeight);															// Set world dimensions
 	mySystem->setLevelsCount(LEVELS_COUNT); 																		// Set levels count
-	loadResources();																								// Load resources
-	loadMap();																										// Load map
+	ResourceManager::loadArchive("res/assets.pak");																	// Use cooked assets when present and valid, loose files otherwise
+#ifdef __DEBUG																										// Debug info
+	ResourceManager::enableHotReload();																				// Pick up edited art and sounds while running
+#endif																												// Debug info
+	loadResources();																								// Queue resources, the map is loaded once they arrive
 }
 
 MyGame::~MyGame() {
@@ -43,9 +50,15 @@ void MyGame::onLeftMouseButton() {
 }
 
 void MyGame::update() {
+	if (!resourcesReady) {																							// IF STILL LOADING
+		if (!ResourceManager::isAsyncLoadComplete()) return;														// wait for the loader threads
+		mySystem->buildSpriteAtlas();																				// pack the sheets the loader threads decoded, only the pages are uploaded here
+		loadMap();																									// load map
+		resourcesReady = true;																						// start playing
+	}
 	if (mySystem->isGameCompleted()) gameWon = true;																// check win condition
 	if (eventSystem && !eventSystem->isPressed(Mouse::BTN_LEFT)) mousePressed = false;								// reset mouse pressed state
-	mySystem->update(deltaTime, playerEntityId);																	// movement system
+	mySystem->update(float(fixedTimeStep), playerEntityId);															// simulate one fixed step
 	if (mySystem->isLevelChanging()) {																				// IF LEVEL CHANGING
 		blockIds.clear();																							// clear block IDs
 		otherEntities.clear();																						// clear other entity IDs
@@ -55,14 +68,15 @@ void MyGame::update() {
 }
 
 void MyGame::render() {
-	mySystem->render(gfx);																							// render world
+	if (!resourcesReady) return;																					// nothing to draw while loading
+	mySystem->render(gfx, interpolation, float(frameTime));															// render world between the last two steps
 }
 
-int MyGame::rightAlignString(const std::string& string, int charWidth) {
-	int width = 0, height = 0;																						// zero initialise width and height
+int MyGame::rightAlignString(TextLabel& label, int charWidth) {
 	Dimension2i winSize = gfx->getCurrentWindowSize();																// get window size
-	if (TTF_SizeText(font, string.c_str(), &width, &height) == 0 && width > 0) return winSize.w - width;			// IF TTF can get width, use it
-	return winSize.w - static_cast<int>(string.length()) * charWidth;												// return estimated width
+	int width = gfx->getTextSize(label).w;																			// width of label texture
+	if (width > 0) return winSize.w - width;																		// IF LABEL HAS A TEXTURE, use its width
+	return winSize.w - static_cast<int>(label.getText().length()) * charWidth;										// return estimated width
 }
 
 void MyGame::renderUI() {
@@ -80,69 +94,84 @@ void MyGame::renderUI() {
 	gfx->fillRect(0, winSize.h - bgHeight, winSize.w, bgHeight);													// fill rect
 	gfx->setDrawColor(SDL_COLOR_BLACK);																				// set colour
 	gfx->drawRect(0, winSize.h - bgHeight, winSize.w, bgHeight);													// draw rect border
+	if (!resourcesReady) {																							// IF STILL LOADING, show progress only
+		loadingLabel.setText("LOADING: ", int(ResourceManager::getAsyncLoadProgress() * 100));						// percentage of queued files done
+		gfx->drawText(loadingLabel, DEFAULT_FONT_SIZE, 8);															// draw
+		return;
+	}
 	// UI TOP TEXT: SCORE (LEFT ALIGNED)
-	gfx->setDrawColor(SDL_COLOR_WHITE);																				// set colour
-	std::string scoreStr = "SCORE: " + std::to_string(mySystem->getScore());										// score string
-	gfx->drawText(scoreStr, DEFAULT_FONT_SIZE, 8);																	// draw
+	scoreLabel.setText("SCORE: ", mySystem->getScore());															// score label
+	gfx->drawText(scoreLabel, DEFAULT_FONT_SIZE, 8);																// draw
 	// UI TOP TEXT: ZOMBIES REMAINING (RIGHT ALIGNED)
-	gfx->setDrawColor(SDL_COLOR_RED);																				// set colour
-	std::string npcStr = "ZOMBIES REMAINING: " + std::to_string(mySystem->getNPCCount());							// NPC count string
-	gfx->drawText(npcStr, rightAlignString(npcStr) - DEFAULT_FONT_SIZE, 8);											// draw right aligned
+	npcLabel.setText("ZOMBIES REMAINING: ", mySystem->getNPCCount());												// NPC count label
+	gfx->drawText(npcLabel, rightAlignString(npcLabel) - DEFAULT_FONT_SIZE, 8);										// draw right aligned
 	// UI BOTTOM TEXT: HEALTH (LEFT ALIGNED)
-	gfx->setDrawColor(SDL_COLOR_GREEN);																				// set colour
-	std::string healthStr = "HEALTH: " + std::to_string(mySystem->getEntityHealth(playerEntityId));					// health string
-	gfx->drawText(healthStr, DEFAULT_FONT_SIZE, winSize.h - bgHeight + 8);											// draw
+	healthLabel.setText("HEALTH: ", mySystem->getEntityHealth(playerEntityId));										// health label
+	gfx->drawText(healthLabel, DEFAULT_FONT_SIZE, winSize.h - bgHeight + 8);										// draw
 	// UI BOTTOM TEXT: AMMO (RIGHT ALIGNED)
-	gfx->setDrawColor(SDL_COLOR_ORANGE);																			// set colour
-	std::string ammoStr = "AMMO: " + std::to_string(mySystem->getAmmo(playerEntityId));								// ammo string
-	gfx->drawText(ammoStr, rightAlignString(ammoStr) - DEFAULT_FONT_SIZE, winSize.h - bgHeight + 8);				// draw right aligned
-	if (gameWon) gfx->drawText("YOU WON", winSize.w / 2, winSize.h * 3 / 4);										// draw win message
+	ammoLabel.setText("AMMO: ", mySystem->getAmmo(playerEntityId));													// ammo label
+	gfx->drawText(ammoLabel, rightAlignString(ammoLabel) - DEFAULT_FONT_SIZE, winSize.h - bgHeight + 8);			// draw right aligned
+	if (gameWon) gfx->drawText(wonLabel, winSize.w / 2, winSize.h * 3 / 4);											// draw win message
+#ifdef __DEBUG																										// Debug info
+	// UI BOTTOM TEXT: DRAW CALLS OF LAST FRAME (CENTRED)
+	drawCallLabel.setText("DRAW CALLS: ", int(gfx->getDrawCallCount()));											// draw call label
+	gfx->drawText(drawCallLabel, winSize.w / 2 - DEFAULT_FONT_SIZE * 4, winSize.h - bgHeight + 8);					// draw
+	// UI TOP TEXT: FRAME TIME PERCENTILES (CENTRED)
+	if (SDL_GetTicks() - frameStatsTime >= 500) {																	// IF HALF A SECOND PASSED, refresh so the text stays readable
+		FrameTimeStats stats = gfx->getFrameTimeStats();															// frame times of recent frames
+		char text[64];																								// label text
+		SDL_snprintf(text, sizeof(text), "MS P50 %.1f P95 %.1f P99 %.1f", stats.p50, stats.p95, stats.p99);			// format percentiles
+		frameStatsLabel.setText(text);																				// frame stats label
+		frameStatsTime = SDL_GetTicks();																			// remember refresh time
+	}
+	gfx->drawText(frameStatsLabel, winSize.w / 2 - DEFAULT_FONT_SIZE * 6, 8);										// draw
+#endif																												// Debug info
 }
 
 void MyGame::loadResources() {
 	// PLAYER SPRITES
-	mySystem->loadSprite("player_idle_down", "res/player_walk_sheet.png", TILE_SIZE, TILE_SIZE, 1, 0, false);
-	mySystem->loadSprite("player_idle_right", "res/player_walk_sheet.png", TILE_SIZE, TILE_SIZE, 1, 3, false);
-	mySystem->loadSprite("player_idle_up", "res/player_walk_sheet.png", TILE_SIZE, TILE_SIZE, 1, 6, false);
-	mySystem->loadSprite("player_walk_down", "res/player_walk_sheet.png", TILE_SIZE, TILE_SIZE, 3, 0, true);
-	mySystem->loadSprite("player_walk_right", "res/player_walk_sheet.png", TILE_SIZE, TILE_SIZE, 3, 3, true);
-	mySystem->loadSprite("player_walk_up", "res/player_walk_sheet.png", TILE_SIZE, TILE_SIZE, 3, 6, true);
-	mySystem->loadSprite("player_death_down", "res/player_death_sheet.png", TILE_SIZE, TILE_SIZE, 3, 0, false);
-	mySystem->loadSprite("player_death_right", "res/player_death_sheet.png", TILE_SIZE, TILE_SIZE, 3, 3, false);
-	mySystem->loadSprite("player_death_up", "res/player_death_sheet.png", TILE_SIZE, TILE_SIZE, 3, 6, false);
+	mySystem->loadSpriteAsync("player_idle_down", "res/player_walk_sheet.png", TILE_SIZE, TILE_SIZE, 1, 0, false);
+	mySystem->loadSpriteAsync("player_idle_right", "res/player_walk_sheet.png", TILE_SIZE, TILE_SIZE, 1, 3, false);
+	mySystem->loadSpriteAsync("player_idle_up", "res/player_walk_sheet.png", TILE_SIZE, TILE_SIZE, 1, 6, false);
+	mySystem->loadSpriteAsync("player_walk_down", "res/player_walk_sheet.png", TILE_SIZE, TILE_SIZE, 3, 0, true);
+	mySystem->loadSpriteAsync("player_walk_right", "res/player_walk_sheet.png", TILE_SIZE, TILE_SIZE, 3, 3, true);
+	mySystem->loadSpriteAsync("player_walk_up", "res/player_walk_sheet.png", TILE_SIZE, TILE_SIZE, 3, 6, true);
+	mySystem->loadSpriteAsync("player_death_down", "res/player_death_sheet.png", TILE_SIZE, TILE_SIZE, 3, 0, false);
+	mySystem->loadSpriteAsync("player_death_right", "res/player_death_sheet.png", TILE_SIZE, TILE_SIZE, 3, 3, false);
+	mySystem->loadSpriteAsync("player_death_up", "res/player_death_sheet.png", TILE_SIZE, TILE_SIZE, 3, 6, false);
 	// NPC SPRITES
-	mySystem->loadSprite("zombie_idle_down", "res/zombie_walk_sheet.png", TILE_SIZE, TILE_SIZE, 1, 0, false);
-	mySystem->loadSprite("zombie_idle_right", "res/zombie_walk_sheet.png", TILE_SIZE, TILE_SIZE, 1, 3, false);
-	mySystem->loadSprite("zombie_idle_up", "res/zombie_walk_sheet.png", TILE_SIZE, TILE_SIZE, 1, 6, false);
-	mySystem->loadSprite("zombie_walk_down", "res/zombie_walk_sheet.png", TILE_SIZE, TILE_SIZE, 3, 0, true);
-	mySystem->loadSprite("zombie_walk_right", "res/zombie_walk_sheet.png", TILE_SIZE, TILE_SIZE, 3, 3, true);
-	mySystem->loadSprite("zombie_walk_up", "res/zombie_walk_sheet.png", TILE_SIZE, TILE_SIZE, 3, 6, true);
-	mySystem->loadSprite("zombie_death_down", "res/zombie_death_sheet.png", TILE_SIZE, TILE_SIZE, 3, 0, false);
-	mySystem->loadSprite("zombie_death_right", "res/zombie_death_sheet.png", TILE_SIZE, TILE_SIZE, 3, 3, false);
-	mySystem->loadSprite("zombie_death_up", "res/zombie_death_sheet.png", TILE_SIZE, TILE_SIZE, 3, 6, false);
+	mySystem->loadSpriteAsync("zombie_idle_down", "res/zombie_walk_sheet.png", TILE_SIZE, TILE_SIZE, 1, 0, false);
+	mySystem->loadSpriteAsync("zombie_idle_right", "res/zombie_walk_sheet.png", TILE_SIZE, TILE_SIZE, 1, 3, false);
+	mySystem->loadSpriteAsync("zombie_idle_up", "res/zombie_walk_sheet.png", TILE_SIZE, TILE_SIZE, 1, 6, false);
+	mySystem->loadSpriteAsync("zombie_walk_down", "res/zombie_walk_sheet.png", TILE_SIZE, TILE_SIZE, 3, 0, true);
+	mySystem->loadSpriteAsync("zombie_walk_right", "res/zombie_walk_sheet.png", TILE_SIZE, TILE_SIZE, 3, 3, true);
+	mySystem->loadSpriteAsync("zombie_walk_up", "res/zombie_walk_sheet.png", TILE_SIZE, TILE_SIZE, 3, 6, true);
+	mySystem->loadSpriteAsync("zombie_death_down", "res/zombie_death_sheet.png", TILE_SIZE, TILE_SIZE, 3, 0, false);
+	mySystem->loadSpriteAsync("zombie_death_right", "res/zombie_death_sheet.png", TILE_SIZE, TILE_SIZE, 3, 3, false);
+	mySystem->loadSpriteAsync("zombie_death_up", "res/zombie_death_sheet.png", TILE_SIZE, TILE_SIZE, 3, 6, false);
 	// GROUND SPRITES
-	mySystem->loadSprite("ground", "res/ground.png", TILE_SIZE, TILE_SIZE, 1, 0);
-	mySystem->loadSprite("ground2", "res/ground2.png", TILE_SIZE, TILE_SIZE, 1, 0);
-	mySystem->loadSprite("ground3", "res/ground3.png", TILE_SIZE, TILE_SIZE, 1, 0);
-	mySystem->loadSprite("ground4", "res/ground4.png", TILE_SIZE, TILE_SIZE, 1, 0);
+	mySystem->loadSpriteAsync("ground", "res/ground.png", TILE_SIZE, TILE_SIZE, 1, 0);
+	mySystem->loadSpriteAsync("ground2", "res/ground2.png", TILE_SIZE, TILE_SIZE, 1, 0);
+	mySystem->loadSpriteAsync("ground3", "res/ground3.png", TILE_SIZE, TILE_SIZE, 1, 0);
+	mySystem->loadSpriteAsync("ground4", "res/ground4.png", TILE_SIZE, TILE_SIZE, 1, 0);
 	// ROAD SPRITES
-	mySystem->loadSprite("road", "res/road.png", TILE_SIZE, TILE_SIZE, 1, 0);
-	mySystem->loadSprite("roadH", "res/roadH.png", TILE_SIZE, TILE_SIZE, 1, 0);
-	mySystem->loadSprite("roadV", "res/roadV.png", TILE_SIZE, TILE_SIZE, 1, 0);
+	mySystem->loadSpriteAsync("road", "res/road.png", TILE_SIZE, TILE_SIZE, 1, 0);
+	mySystem->loadSpriteAsync("roadH", "res/roadH.png", TILE_SIZE, TILE_SIZE, 1, 0);
+	mySystem->loadSpriteAsync("roadV", "res/roadV.png", TILE_SIZE, TILE_SIZE, 1, 0);
 	// BLOCK SPRITE
-	mySystem->loadSprite("block", "res/wall.png", TILE_SIZE, TILE_SIZE, 1, 0);
+	mySystem->loadSpriteAsync("block", "res/wall.png", TILE_SIZE, TILE_SIZE, 1, 0);
 	// ITEM SPRITES
-	mySystem->loadSprite("bullet", "res/bullet.png", TILE_SIZE, TILE_SIZE, 1, 0, false, 0.5f);
-	mySystem->loadSprite("healthPickUp", "res/health.png", TILE_SIZE, TILE_SIZE, 1, 0);
-	mySystem->loadSprite("ammoPickup", "res/ammo.png", TILE_SIZE, TILE_SIZE, 1, 0);
-	mySystem->loadSprite("endLevel", "res/endLevel.png", TILE_SIZE, TILE_SIZE, 1, 0);
+	mySystem->loadSpriteAsync("bullet", "res/bullet.png", TILE_SIZE, TILE_SIZE, 1, 0, false, 0.5f);
+	mySystem->loadSpriteAsync("healthPickUp", "res/health.png", TILE_SIZE, TILE_SIZE, 1, 0);
+	mySystem->loadSpriteAsync("ammoPickup", "res/ammo.png", TILE_SIZE, TILE_SIZE, 1, 0);
+	mySystem->loadSpriteAsync("endLevel", "res/endLevel.png", TILE_SIZE, TILE_SIZE, 1, 0);
 	// LOAD SOUNDS
-	mySystem->loadSound("shoot", "res/sfx/shoot.wav");
-	mySystem->loadSound("zombie_hit_sound", "res/sfx/zombie_hit.wav");
-	mySystem->loadSound("player_hit_sound", "res/sfx/player_death.wav");
-	mySystem->loadSound("heal_sound", "res/sfx/heal_sound.wav");
-	mySystem->loadSound("ammo_sound", "res/sfx/ammo.wav");
-	mySystem->loadSound("endLevel_sound", "res/sfx/endLevel_sound.wav");
+	mySystem->loadSoundAsync("shoot", "res/sfx/shoot.wav");
+	mySystem->loadSoundAsync("zombie_hit_sound", "res/sfx/zombie_hit.wav");
+	mySystem->loadSoundAsync("player_hit_sound", "res/sfx/player_death.wav");
+	mySystem->loadSoundAsync("heal_sound", "res/sfx/heal_sound.wav");
+	mySystem->loadSoundAsync("ammo_sound", "res/sfx/ammo.wav");
+	mySystem->loadSoundAsync("endLevel_sound", "res/sfx/endLevel_sound.wav");
 }
 
 void MyGame::loadMap() {
@@ -162,7 +191,7 @@ void MyGame::loadMap() {
 			mySystem->addGroundTile(groundAnim, posX, posY);														// add ground tile
 			Uint32 slotContent = levelmap.map[mySystem->getCurrentLevel()][row][col];								// get slot content
 			switch (slotContent) {																					// SWITCH BASED ON SLOT CONTENT
-			case 1: { uint32_t id = spawnBlock(float(posX), float(posY)); blockIds.push_back(id); break; }			// spawn block
+			case 1: { spawnBlock(float(posX), float(posY)); break; }												// spawn block
 			case 2: {
 				if (playerEntityId >= 0)																			// IF PLAYER EXISTS
 					mySystem->setEntityPosition(playerEntityId, Vector2f(float(posX), float(posY)));				// move existing player
@@ -190,9 +219,9 @@ void MyGame::trySpawnItem(Uint32 count, std::function<Uint32(float, float)> func
 			Uint32 randCol = getRandom(TILE_SIZE, worldWidth - TILE_SIZE);											// random x
 			Uint32 randRow = getRandom(TILE_SIZE, worldHeight - TILE_SIZE);											// random y
 			SDL_Rect itemRect = { randCol, randRow, TILE_SIZE, TILE_SIZE };											// item rect
-			bool collision = false;																					// collision flag
-			for (Uint32 blockId : blockIds) {																		// FOR EACH BLOCK
-				SDL_Rect blockRect = mySystem->getEntityColliderRect(blockId);										// get block rect
+			bool collision = mySystem->isStaticTileInRect(itemRect);												// collision flag, set if item overlaps a wall
+			for (Uint32 blockId : blockIds) {																		// FOR EACH PICKUP ALREADY PLACED
+				SDL_Rect blockRect = mySystem->getEntityColliderRect(blockId);										// get pickup rect
 				if (SDL_HasIntersection(&blockRect, &itemRect)) { collision = true; break; }						// IF INTERSECTION, set collision flag and break
 			}
 			if (!collision) {																						// IF NO COLLISION
@@ -249,12 +278,8 @@ uint32_t MyGame::spawnNPC(float x, float y) {
 	return entity;																									// return entity
 }
 
-uint32_t MyGame::spawnBlock(float x, float y) {
-	uint32_t entity = mySystem->createEntity();																		// create entity
-	mySystem->attachSprite(entity, "block");																		// add block sprite
-	mySystem->addComponentTransform(entity, Vector2f(x, y), 1, 0, OBJECT_LAYER);									// add transform component
-	mySystem->addComponentCollider(entity, x, y, TILE_SIZE, TILE_SIZE);												// add collider component
-	return entity;																									// return entity
+void MyGame::spawnBlock(float x, float y) {
+	mySystem->addStaticTile("block", int(x), int(y));																// add wall to static collision layer
 }
 
 uint32_t MyGame::spawnAmmoPickup(float x, float y) {
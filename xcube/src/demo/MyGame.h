@@ -9,13 +9,16 @@ class MyGame : public AbstractGame {
 private:
 	int numAmmo, numHealth, lives;											// game stats
 	bool gameWon;															// win state
-	std::vector<uint32_t> blockIds, otherEntities;							// Block entity IDs
+	std::vector<uint32_t> blockIds, otherEntities;							// Pickup and other entity IDs
 	Level levelmap = {};													// level map
 	int worldWidth = LEVEL_COLS * TILE_SIZE;								// world dimensions
 	int worldHeight = LEVEL_ROWS * TILE_SIZE;								// world dimensions
 	int playerEntityId = { -1 };											// -1 = not spawned
 	bool mousePressed = false;												// mouse pressed state
+	bool resourcesReady = false;											// async loads finished and map loaded
+	Uint32 frameStatsTime = 0;												// last refresh of the frame time label
 	TTF_Font* font = nullptr;												// font
+	TextLabel scoreLabel, npcLabel, healthLabel, ammoLabel, wonLabel, drawCallLabel, loadingLabel, frameStatsLabel;	// HUD text, rebuilt only when changed
 	void handleKeyEvents();													// handle key events
 	void onLeftMouseButton();												// handle mouse events
 	void update();															// update
@@ -23,12 +26,12 @@ private:
 	void renderUI();														// render UI
 	void loadMap();															// load level map
 	void loadResources();													// load resources
-	int rightAlignString(const std::string& string, int charWidth = 24);	// get UI string width
+	int rightAlignString(TextLabel& label, int charWidth = 24);				// get right aligned x of UI label
 	// SPAWN METHODS
 	void trySpawnItem(Uint32 count, std::function<Uint32(float, float)> func);	// try spawn pickups
 	uint32_t spawnPC(float x, float y);										// spawn player character
 	uint32_t spawnNPC(float x, float y);									// spawn NPC
-	uint32_t spawnBlock(float x, float y);									// spawn block
+	void spawnBlock(float x, float y);										// spawn block
 	uint32_t spawnAmmoPickup(float x, float y);								// spawn ammo pickup
 	uint32_t spawnHealthPickup(float x, float y);							// spawn health pickup
 	uint32_t spawnEndLevelTrigger(float x, float y);						// spawn end level trigger
@@ -1,6 +1,7 @@
 #include "AbstractGame.h"
 
-AbstractGame::AbstractGame() : running(true), paused(false), gameTime(0.0) {
+AbstractGame::AbstractGame() : running(true), paused(false), gameTime(0.0),
+	fixedTimeStep(1.0 / 60.0), maxStepsPerFrame(5), interpolation(0.0f), frameTime(0.0) {
 	std::shared_ptr<XCube2Engine> engine = XCube2Engine::getInstance();
 
 	// engine ready, get subsystems
@@ -22,13 +23,20 @@ AbstractGame::~AbstractGame() {
 	gfx.reset();
 	eventSystem.reset();
 
+#ifdef __PROFILE
+	Profiler::stopTrace();
+#endif
+
 	// kill engine
 	XCube2Engine::quit();
 
 #ifdef __DEBUG
 	debug("AbstractGame::~AbstractGame() finished");
-	debug("The game finished and cleaned up successfully. Press Enter to exit");
-	getchar();
+	// headless runs are unattended, only wait for Enter when someone is watching the window
+	if (!XCube2Engine::isHeadless()) {
+		debug("The game finished and cleaned up successfully. Press Enter to exit");
+		getchar();
+	}
 #endif
 }
 
@@ -37,29 +45,85 @@ int AbstractGame::runMainLoop() {
 	debug("Entered Main Loop");
 #endif
 
+	Uint64 previousCounter = SDL_GetPerformanceCounter();
+	double accumulator = 0.0;
+#ifdef __PROFILE
+	bool overlayKeyHeld = false;
+#endif
+
 	while (running) {
 		gfx->setFrameStart();
-		eventSystem->pollEvents();
+		Uint64 counter = SDL_GetPerformanceCounter();
+		frameTime = (double)(counter - previousCounter) / SDL_GetPerformanceFrequency();
+		previousCounter = counter;
+
+		{
+			PROFILE_ZONE("events");
+			eventSystem->pollEvents();
+		}
+		{
+			PROFILE_ZONE("asyncLoads");
+			ResourceManager::processAsyncLoads();	// upload whatever the loader threads finished decoding
+		}
 
 		if (eventSystem->isPressed(Key::ESC) || eventSystem->isPressed(Key::QUIT))
 			running = false;
 
-		handleKeyEvents();
-		handleMouseEvents();
+		{
+			PROFILE_ZONE("input");
+			handleKeyEvents();
+			handleMouseEvents();
+		}
 
-		if (!paused) {
-			update();
-			updatePhysics();
+#ifdef __PROFILE
+		// F3 shows or hides the profiler overlay, once per press
+		if (eventSystem->isPressed(Key::F3) && !overlayKeyHeld)
+			Profiler::toggleOverlay();
+		overlayKeyHeld = eventSystem->isPressed(Key::F3);
+#endif
 
-			gameTime += 0.016;	// 60 times a sec
+		if (!paused) {
+			// cap the backlog, after a stall the game resumes slightly behind instead of running many steps to catch up
+			accumulator = std::min(accumulator + frameTime, fixedTimeStep * maxStepsPerFrame);
+			while (accumulator >= fixedTimeStep) {
+				PROFILE_ZONE("update");
+				update();
+				updatePhysics();
+
+				gameTime += fixedTimeStep;
+				accumulator -= fixedTimeStep;
+			}
+		}
+		else {
+			accumulator = 0.0;	// time spent paused is not simulated on resume
 		}
+		interpolation = (float)(accumulator / fixedTimeStep);
 
 		gfx->clearScreen();
-		render();
-		renderUI();
-		gfx->showScreen();
+		{
+			PROFILE_ZONE("render");
+			render();
+		}
+		{
+			PROFILE_ZONE("renderUI");
+			renderUI();
+		}
+#ifdef __PROFILE
+		Profiler::drawOverlay(gfx);
+#endif
+		{
+			PROFILE_ZONE("present");	// includes waiting for vsync
+			gfx->showScreen();
+		}
+		PROFILE_COUNTER("drawCalls", gfx->getDrawCallCount());
 
-		gfx->adjustFPSDelay(16);	// atm hardcoded to ~60 FPS
+		{
+			PROFILE_ZONE("frameDelay");
+			gfx->adjustFPSDelay();	// no-op unless gfx->setTargetFrameRate() was called
+		}
+#ifdef __PROFILE
+		Profiler::endFrame();
+#endif
 	}
 
 #ifdef __DEBUG
@@ -69,12 +133,40 @@ int AbstractGame::runMainLoop() {
 	return 0;
 }
 
+int AbstractGame::runHeadless(const Uint64 & steps) {
+#ifdef __DEBUG
+	debug("Entered headless loop");
+#endif
+
+	Uint64 start = SDL_GetPerformanceCounter();
+	Uint64 step = 0;
+	for (; step < steps && running; ++step) {
+		ResourceManager::processAsyncLoads();
+		{
+			PROFILE_ZONE("update");
+			update();
+			updatePhysics();
+		}
+
+		gameTime += fixedTimeStep;
+#ifdef __PROFILE
+		Profiler::endFrame();	// one step is one frame in traces, and keeps the sample ring drained
+#endif
+	}
+	double seconds = (double)(SDL_GetPerformanceCounter() - start) / SDL_GetPerformanceFrequency();
+
+	std::cout << "Simulated " << step << " steps (" << gameTime << " s of game time) in " << seconds << " s, "
+		<< (seconds > 0.0 ? step / seconds : 0.0) << " steps/s" << std::endl;
+	return 0;
+}
+
 void AbstractGame::handleMouseEvents() {
 	if (eventSystem->isPressed(Mouse::BTN_LEFT)) onLeftMouseButton();
 	if (eventSystem->isPressed(Mouse::BTN_RIGHT)) onRightMouseButton();
 }
 
 void AbstractGame::updatePhysics() {
+	PROFILE_ZONE("physics");
 	physics->update();
 }
 
@@ -24,6 +24,18 @@ class AbstractGame {
         bool paused;
 		double gameTime;
 
+		/**
+		* update() runs at a fixed rate of one step per fixedTimeStep seconds of real time,
+		* however often frames are rendered. At most maxStepsPerFrame steps run in one frame,
+		* the rest of a long stall is dropped so a slow frame cannot cause ever more steps.
+		* interpolation is how far real time is past the last step, as a fraction of a step,
+		* for render() to blend between the previous and current state
+		*/
+		double fixedTimeStep;
+		int maxStepsPerFrame;
+		float interpolation;
+		double frameTime;	// real seconds between the last two frames
+
 		virtual void handleKeyEvents() = 0;
 
 		virtual void onLeftMouseButton();
@@ -38,6 +50,13 @@ class AbstractGame {
 		void resume() { paused = false; }
 	public:
 		int runMainLoop();
+
+		/**
+		* Runs steps fixed updates back to back with no events, rendering or pacing,
+		* for soak tests and benchmarks, normally with XCube2Engine::setHeadless(true).
+		* Prints the steps simulated per second
+		*/
+		int runHeadless(const Uint64 & steps);
 };
 
 #endif
\ No newline at end of file
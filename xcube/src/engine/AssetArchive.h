@@ -0,0 +1,46 @@
+#ifndef __ASSET_ARCHIVE_H__
+#define __ASSET_ARCHIVE_H__
+
+#include <SDL.h>
+
+/**
+* Layout of the packed asset archive written by AssetCooker (tools/)
+* and memory-mapped by ResourceManager::loadArchive()
+*
+* [AssetArchiveHeader][AssetEntry x entryCount][blobs...]
+*
+* Images are stored decoded as SDL_PIXELFORMAT_RGBA32 rows of width * 4 bytes,
+* sounds as PCM already converted to the format the mixer is opened with,
+* so nothing is decoded or converted when they are loaded.
+* Values are in the byte order of the machine that cooked the archive
+*/
+
+static const Uint32 ASSET_ARCHIVE_MAGIC = 0x4B435058;	// "XPCK"
+static const Uint32 ASSET_ARCHIVE_VERSION = 1;
+static const Uint32 ASSET_ARCHIVE_ALIGNMENT = 16;	// every blob starts on this boundary
+static const int ASSET_NAME_LENGTH = 120;
+
+enum AssetType : Uint32 {
+	ASSET_IMAGE = 1,
+	ASSET_SOUND = 2
+};
+
+struct AssetArchiveHeader {
+	Uint32 magic;
+	Uint32 version;
+	Uint32 entryCount;
+	Uint32 reserved;
+};
+
+struct AssetEntry {
+	char name[ASSET_NAME_LENGTH];	// file name the asset was cooked from, as passed to load*
+	Uint32 type;
+	Uint32 reserved;
+	Uint64 offset;	// from the start of the archive
+	Uint64 size;
+	Uint32 width, height;	// ASSET_IMAGE
+	Uint32 frequency;	// ASSET_SOUND
+	Uint16 format, channels;	// ASSET_SOUND
+};
+
+#endif
@@ -14,6 +14,14 @@
 */
 #define __DEBUG
 
+/**
+    Timing zones and the profiler overlay (Profiler.h) are part of the debug code,
+    so a release build compiles them out with the rest of it
+*/
+#ifdef __DEBUG
+#define __PROFILE
+#endif
+
 inline void debug(const char* msg, const char* details = "") {
     std::cout << "DEBUG: " << msg << " " << details << std::endl;
 }
@@ -40,6 +40,7 @@ void EventEngine::updateKeys(const SDL_Keycode &key, bool keyDown) {
 		case SDLK_s:		index = Key::S; break;
 		case SDLK_ESCAPE:	index = Key::ESC; break;
 		case SDLK_SPACE:	index = Key::SPACE; break;
+		case SDLK_F3:		index = Key::F3; break;
 		default:
 			return;	// we don't care about other keys, at least now
 	}
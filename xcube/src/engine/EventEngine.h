@@ -10,7 +10,7 @@
 #include "GameMath.h"
 
 enum Key {
-	W, S, A, D, ESC, SPACE, UP, DOWN, LEFT, RIGHT, QUIT, LAST
+	W, S, A, D, ESC, SPACE, UP, DOWN, LEFT, RIGHT, F3, QUIT, LAST
 };
 
 enum Mouse {
@@ -2,6 +2,8 @@
 #define __GAME_MATH_H__
 
 #include <cstdlib>
+#include <cmath>
+#include <vector>
 
 #include <SDL_rect.h>
 
@@ -136,4 +138,15 @@ inline int getRandom(int min, int max) {
 	return (int)(rand() % (max - min)) + min;
 }
 
+/**
+* Nearest rank percentile, the smallest value that at least p of the values do not exceed
+*
+* @param sorted - values in ascending order, at least one
+* @param p - fraction of the values, between 0 and 1
+*/
+inline double getPercentile(const std::vector<double> & sorted, double p) {
+	size_t rank = (size_t)std::ceil(p * sorted.size());
+	return sorted[(rank > 1 ? rank : 1) - 1];
+}
+
 #endif
@@ -1,8 +1,11 @@
 #include "GraphicsEngine.h"
 
+#include <algorithm>
+
 SDL_Renderer* GraphicsEngine::renderer = nullptr;
 
-GraphicsEngine::GraphicsEngine() : fpsAverage(0), fpsPrevious(0), fpsStart(0), fpsEnd(0), drawColor(toSDLColor(0, 0, 0, 255)) {
+GraphicsEngine::GraphicsEngine() : drawColor(toSDLColor(0, 0, 0, 255)), frameStart(0), targetFrameTicks(0), frameTimeCount(0), frameTimeIndex(0),
+	drawCalls(0), lastFrameDrawCalls(0), renderTargetResets(0), batching(false), batchTexture(nullptr) {
 	window = SDL_CreateWindow("The X-CUBE 2D Game Engine",
 		SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
 		DEFAULT_WINDOW_WIDTH, DEFAULT_WINDOW_HEIGHT, SDL_WINDOW_SHOWN);
@@ -15,6 +18,8 @@ GraphicsEngine::GraphicsEngine() : fpsAverage(0), fpsPrevious(0), fpsStart(0), f
 	if (nullptr == renderer)
 		throw EngineException("Failed to create renderer", SDL_GetError());
 
+	SDL_AddEventWatch(onRenderReset, this);
+
 	// although not necessary, SDL doc says to prevent hiccups load it before using
 	if ((IMG_Init(IMG_INIT_PNG) & IMG_INIT_PNG) != IMG_INIT_PNG)
 		throw EngineException("Failed to init SDL_image - PNG", IMG_GetError());
@@ -28,6 +33,11 @@ GraphicsEngine::~GraphicsEngine() {
 	debug("GraphicsEngine::~GraphicsEngine() started");
 #endif
 
+	for (auto& atlas : glyphAtlases)
+		SDL_DestroyTexture(atlas.second.texture);
+	glyphAtlases.clear();
+
+	SDL_DelEventWatch(onRenderReset, this);
 	IMG_Quit();
 	TTF_Quit();
 	SDL_DestroyWindow(window);
@@ -38,6 +48,12 @@ GraphicsEngine::~GraphicsEngine() {
 #endif
 }
 
+int SDLCALL GraphicsEngine::onRenderReset(void* userdata, SDL_Event* event) {
+	if (event->type == SDL_RENDER_TARGETS_RESET || event->type == SDL_RENDER_DEVICE_RESET)
+		++static_cast<GraphicsEngine*>(userdata)->renderTargetResets;
+	return 0;
+}
+
 void GraphicsEngine::setWindowTitle(const char* title) {
 	SDL_SetWindowTitle(window, title);
 #ifdef __DEBUG
@@ -123,8 +139,19 @@ void GraphicsEngine::clearScreen() {
 	SDL_SetRenderDrawColor(renderer, drawColor.r, drawColor.g, drawColor.b, drawColor.a);	// may need to be adjusted for allowing alpha // ADJUSTED: 255 to drawColor.a
 }
 
+void GraphicsEngine::clearScreen(const SDL_Color& color) {
+	SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
+	SDL_RenderClear(renderer);
+	SDL_SetRenderDrawColor(renderer, drawColor.r, drawColor.g, drawColor.b, drawColor.a);
+}
+
 void GraphicsEngine::showScreen() {
+	if (batching)
+		endSpriteBatch();
+
 	SDL_RenderPresent(renderer);
+	lastFrameDrawCalls = drawCalls;
+	drawCalls = 0;
 }
 
 void GraphicsEngine::useFont(TTF_Font* _font) {
@@ -139,22 +166,60 @@ void GraphicsEngine::useFont(TTF_Font* _font) {
 }
 
 void GraphicsEngine::setFrameStart() {
-	fpsStart = SDL_GetTicks();
+	Uint64 now = SDL_GetPerformanceCounter();
+	if (frameStart != 0) {
+		frameTimes[frameTimeIndex] = (double)(now - frameStart) * 1000.0 / SDL_GetPerformanceFrequency();
+		frameTimeIndex = (frameTimeIndex + 1) % FRAME_HISTORY;
+		if (frameTimeCount < FRAME_HISTORY)
+			++frameTimeCount;
+	}
+	frameStart = now;
 }
 
-void GraphicsEngine::adjustFPSDelay(const Uint32& delay) {
-	fpsEnd = SDL_GetTicks() - fpsStart;
-	if (fpsEnd < delay) {
-		SDL_Delay(delay - fpsEnd);
-	}
+void GraphicsEngine::setTargetFrameRate(const Uint32& fps) {
+	targetFrameTicks = fps > 0 ? SDL_GetPerformanceFrequency() / fps : 0;
+}
+
+void GraphicsEngine::adjustFPSDelay() {
+	if (0 == targetFrameTicks)
+		return;
 
-	Uint32 fpsCurrent = 1000 / (SDL_GetTicks() - fpsStart);
-	fpsAverage = (fpsCurrent + fpsPrevious + fpsAverage * 8) / 10;	// average, 10 values / 10
-	fpsPrevious = fpsCurrent;
+	Uint64 frequency = SDL_GetPerformanceFrequency();
+	Uint64 deadline = frameStart + targetFrameTicks;
+	Uint64 spinTicks = frequency / 500;	// the last 2 ms are spun
+	Uint64 now = SDL_GetPerformanceCounter();
+	if (now + spinTicks < deadline)
+		SDL_Delay((Uint32)((deadline - spinTicks - now) * 1000 / frequency));
+	while (SDL_GetPerformanceCounter() < deadline)
+		;
+}
+
+FrameTimeStats GraphicsEngine::getFrameTimeStats() {
+	FrameTimeStats stats = {};
+	if (0 == frameTimeCount)
+		return stats;
+
+	std::vector<double> sorted(frameTimes, frameTimes + frameTimeCount);
+	std::sort(sorted.begin(), sorted.end());
+
+	double total = 0.0;
+	for (double time : sorted)
+		total += time;
+
+	stats.average = total / sorted.size();
+	stats.p50 = getPercentile(sorted, 0.50);
+	stats.p95 = getPercentile(sorted, 0.95);
+	stats.p99 = getPercentile(sorted, 0.99);
+	stats.max = sorted.back();
+	stats.frames = frameTimeCount;
+	return stats;
 }
 
 Uint32 GraphicsEngine::getAverageFPS() {
-	return fpsAverage;
+	double total = 0.0;
+	for (int i = 0; i < frameTimeCount; ++i)
+		total += frameTimes[i];
+	return total > 0.0 ? (Uint32)(frameTimeCount * 1000.0 / total + 0.5) : 0;
 }
 
 SDL_Texture* GraphicsEngine::createTextureFromSurface(SDL_Surface* surf) {
@@ -176,6 +241,28 @@ SDL_Texture* GraphicsEngine::createTextureFromString(const std::string& text, TT
 	return textTexture;
 }
 
+SDL_Texture* GraphicsEngine::createRenderTarget(const int& w, const int& h) {
+	if (SDL_RenderTargetSupported(renderer) != SDL_TRUE)
+		return nullptr;
+
+	SDL_Texture* target = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, w, h);
+	if (target != nullptr) {
+		SDL_SetTextureBlendMode(target, SDL_BLENDMODE_BLEND);
+	}
+	else {
+		std::cout << "Failed to create render target " << w << "x" << h << std::endl;
+		std::cout << SDL_GetError() << std::endl;
+	}
+
+	return target;
+}
+
+void GraphicsEngine::setRenderTarget(SDL_Texture* target) {
+	flushSpriteBatch();
+	batchTexture = nullptr;
+	SDL_SetRenderTarget(renderer, target);
+}
+
 void GraphicsEngine::setDrawScale(const Vector2f& v) {
 	SDL_RenderSetScale(renderer, v.x, v.y);
 }
@@ -185,48 +272,63 @@ void GraphicsEngine::setDrawScale(const Vector2f& v) {
 
 void GraphicsEngine::drawRect(const Rectangle2& rect) {
 	SDL_RenderDrawRect(renderer, &rect.getSDLRect());
+	++drawCalls;
 }
 
 void GraphicsEngine::drawRect(const Rectangle2& rect, const SDL_Color& color) {
 	SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, 255);
 	SDL_RenderDrawRect(renderer, &rect.getSDLRect());
+	++drawCalls;
 	SDL_SetRenderDrawColor(renderer, drawColor.r, drawColor.g, drawColor.b, 255);
 }
 
 void GraphicsEngine::drawRect(SDL_Rect* rect, const SDL_Color& color) {
 	SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, 255);
 	SDL_RenderDrawRect(renderer, rect);
+	++drawCalls;
 	SDL_SetRenderDrawColor(renderer, drawColor.r, drawColor.g, drawColor.b, 255);
 }
 
 void GraphicsEngine::drawRect(SDL_Rect* rect) {
 	SDL_RenderDrawRect(renderer, rect);
+	++drawCalls;
 }
 
 void GraphicsEngine::drawRect(const int& x, const int& y, const int& w, const int& h) {
 	SDL_Rect rect = { x, y, w, h };
 	SDL_RenderDrawRect(renderer, &rect);
+	++drawCalls;
 }
 
 void GraphicsEngine::fillRect(SDL_Rect* rect) {
 	SDL_RenderFillRect(renderer, rect);
+	++drawCalls;
 }
 
 void GraphicsEngine::fillRect(const int& x, const int& y, const int& w, const int& h) {
 	SDL_Rect rect = { x, y, w, h };
 	SDL_RenderFillRect(renderer, &rect);
+	++drawCalls;
+}
+
+void GraphicsEngine::fillRects(const SDL_Rect* rects, const int& count) {
+	SDL_RenderFillRects(renderer, rects, count);
+	++drawCalls;
 }
 
 void GraphicsEngine::drawPoint(const Point2& p) {
 	SDL_RenderDrawPoint(renderer, p.x, p.y);
+	++drawCalls;
 }
 
 void GraphicsEngine::drawLine(const Line2i& line) {
 	SDL_RenderDrawLine(renderer, line.start.x, line.start.y, line.end.x, line.end.y);
+	++drawCalls;
 }
 
 void GraphicsEngine::drawLine(const Point2& p0, const Point2& p1) {
 	SDL_RenderDrawLine(renderer, p0.x, p0.y, p1.x, p1.y);
+	++drawCalls;
 }
 
 void GraphicsEngine::drawCircle(const Point2& center, const float& radius) {
@@ -234,6 +336,7 @@ void GraphicsEngine::drawCircle(const Point2& center, const float& radius) {
 		int x = (int)(center.x + radius * cos(i));
 		int y = (int)(center.y + radius * sin(i));
 		SDL_RenderDrawPoint(renderer, x, y);
+		++drawCalls;
 	}
 }
 
@@ -242,22 +345,312 @@ void GraphicsEngine::drawEllipse(const Point2& center, const float& radiusX, con
 		int x = (int)(center.x + radiusX * cos(i));
 		int y = (int)(center.y + radiusY * sin(i));
 		SDL_RenderDrawPoint(renderer, x, y);
+		++drawCalls;
 	}
 }
 
 void GraphicsEngine::drawTexture(SDL_Texture* texture, SDL_Rect* src, SDL_Rect* dst, const double& angle, const SDL_Point* center, SDL_RendererFlip flip) {
 	SDL_RenderCopyEx(renderer, texture, src, dst, angle, center, flip);
+	++drawCalls;
 }
 
 void GraphicsEngine::drawTexture(SDL_Texture* texture, SDL_Rect* dst, SDL_RendererFlip flip) {
 	SDL_RenderCopyEx(renderer, texture, 0, dst, 0.0, 0, flip);
+	++drawCalls;
 }
 
 void GraphicsEngine::drawText(const std::string& text, const int& x, const int& y) {
-	SDL_Texture* textTexture = createTextureFromString(text, font, drawColor);
-	int w, h;
-	SDL_QueryTexture(textTexture, 0, 0, &w, &h);
-	SDL_Rect dst = { x, y, w, h };
-	drawTexture(textTexture, &dst);
-	SDL_DestroyTexture(textTexture);
-}
\ No newline at end of file
+	GlyphAtlas* atlas = getGlyphAtlas(font);
+	if (nullptr == atlas)
+		return;
+
+	// a string is one run of quads from the atlas, unless already inside a larger batch
+	bool ownBatch = !batching;
+	if (ownBatch)
+		beginSpriteBatch();
+
+	int penX = x, previous = -1;
+	for (char c : text) {
+		int glyph = glyphIndex(c);
+		if (previous >= 0)
+			penX += atlas->kerning[previous * GLYPH_COUNT + glyph];
+
+		const SDL_Rect& src = atlas->glyphs[glyph];
+		if (src.w > 0) {
+			SDL_Rect dst = { penX + atlas->offsets[glyph], y, src.w, src.h };
+			drawSprite(atlas->texture, src, dst, 0.0, SDL_FLIP_NONE, drawColor);
+		}
+		penX += atlas->advances[glyph];
+		previous = glyph;
+	}
+
+	if (ownBatch)
+		endSpriteBatch();
+}
+
+Dimension2i GraphicsEngine::getTextSize(const std::string& text) {
+	GlyphAtlas* atlas = getGlyphAtlas(font);
+	if (nullptr == atlas)
+		return Dimension2i();
+
+	int width = 0, previous = -1;
+	for (char c : text) {
+		int glyph = glyphIndex(c);
+		if (previous >= 0)
+			width += atlas->kerning[previous * GLYPH_COUNT + glyph];
+		width += atlas->advances[glyph];
+		previous = glyph;
+	}
+
+	return Dimension2i(width, TTF_FontHeight(font));
+}
+
+void GraphicsEngine::drawText(TextLabel& label, const int& x, const int& y) {
+	updateTextLabel(label);
+	if (nullptr == label.texture)
+		return;
+
+	SDL_Rect src = { 0, 0, label.size.w, label.size.h };
+	SDL_Rect dst = { x, y, label.size.w, label.size.h };
+	drawSprite(label.texture, src, dst);
+}
+
+Dimension2i GraphicsEngine::getTextSize(TextLabel& label) {
+	updateTextLabel(label);
+	return label.size;
+}
+
+void GraphicsEngine::updateTextLabel(TextLabel& label) {
+	if (!label.dirty && label.font == font)
+		return;
+
+	if (label.texture != nullptr)
+		SDL_DestroyTexture(label.texture);
+
+	label.texture = nullptr;
+	label.size = Dimension2i();
+	if (font != nullptr && !label.text.empty())
+		label.texture = createTextureFromString(label.text, font, label.color);
+	if (label.texture != nullptr)
+		SDL_QueryTexture(label.texture, 0, 0, &label.size.w, &label.size.h);
+
+	label.font = font;
+	label.dirty = false;
+}
+
+int GraphicsEngine::glyphIndex(char c) {
+	int index = (unsigned char)c - FIRST_GLYPH;
+	return (index >= 0 && index < GLYPH_COUNT) ? index : '?' - FIRST_GLYPH;
+}
+
+GraphicsEngine::GlyphAtlas* GraphicsEngine::getGlyphAtlas(TTF_Font* _font) {
+	if (nullptr == _font)
+		return nullptr;
+
+	auto found = glyphAtlases.find(_font);
+	if (found != glyphAtlases.end())
+		return found->second.texture != nullptr ? &found->second : nullptr;
+
+	// rasterize every glyph once and pack them into rows of the atlas
+	const int atlasWidth = 512;
+	GlyphAtlas& atlas = glyphAtlases[_font];
+	atlas.texture = nullptr;
+	SDL_Surface* glyphSurfaces[GLYPH_COUNT];
+	int rowX = 0, rowY = 0, rowH = 0;
+	for (int i = 0; i < GLYPH_COUNT; ++i) {
+		Uint16 ch = (Uint16)(FIRST_GLYPH + i);
+		int minX = 0, advance = 0;
+		TTF_GlyphMetrics(_font, ch, &minX, nullptr, nullptr, nullptr, &advance);
+		atlas.advances[i] = advance;
+		atlas.offsets[i] = std::min(0, minX);	// same origin TTF_RenderText uses for a leading glyph
+
+		glyphSurfaces[i] = TTF_GlyphIsProvided(_font, ch) ? TTF_RenderGlyph_Blended(_font, ch, SDL_COLOR_WHITE) : nullptr;
+		if (nullptr == glyphSurfaces[i]) {
+			atlas.glyphs[i] = { 0, 0, 0, 0 };
+			continue;
+		}
+
+		if (rowX + glyphSurfaces[i]->w > atlasWidth) {
+			rowX = 0;
+			rowY += rowH + 1;
+			rowH = 0;
+		}
+		atlas.glyphs[i] = { rowX, rowY, glyphSurfaces[i]->w, glyphSurfaces[i]->h };
+		rowX += glyphSurfaces[i]->w + 1;
+		rowH = std::max(rowH, glyphSurfaces[i]->h);
+	}
+
+	SDL_Surface* atlasSurface = SDL_CreateRGBSurfaceWithFormat(0, atlasWidth, std::max(1, rowY + rowH), 32, SDL_PIXELFORMAT_RGBA32);
+	if (atlasSurface != nullptr) {
+		SDL_FillRect(atlasSurface, nullptr, SDL_MapRGBA(atlasSurface->format, 255, 255, 255, 0));
+		for (int i = 0; i < GLYPH_COUNT; ++i) {
+			if (nullptr == glyphSurfaces[i])
+				continue;
+			// copy alpha as is instead of blending onto the empty atlas
+			SDL_SetSurfaceBlendMode(glyphSurfaces[i], SDL_BLENDMODE_NONE);
+			SDL_Rect dst = atlas.glyphs[i];	// SDL_BlitSurface writes the clipped rect back
+			SDL_BlitSurface(glyphSurfaces[i], nullptr, atlasSurface, &dst);
+		}
+		atlas.texture = SDL_CreateTextureFromSurface(renderer, atlasSurface);
+		SDL_FreeSurface(atlasSurface);
+	}
+	for (SDL_Surface* glyphSurface : glyphSurfaces)
+		SDL_FreeSurface(glyphSurface);
+
+	if (nullptr == atlas.texture) {
+		std::cout << "Failed to create glyph atlas" << std::endl;
+		std::cout << SDL_GetError() << std::endl;
+		return nullptr;
+	}
+	SDL_SetTextureBlendMode(atlas.texture, SDL_BLENDMODE_BLEND);
+
+	atlas.kerning.assign(GLYPH_COUNT * GLYPH_COUNT, 0);
+	if (TTF_GetFontKerning(_font)) {
+		for (int previous = 0; previous < GLYPH_COUNT; ++previous)
+			for (int current = 0; current < GLYPH_COUNT; ++current)
+				atlas.kerning[previous * GLYPH_COUNT + current] = TTF_GetFontKerningSizeGlyphs(_font, (Uint16)(FIRST_GLYPH + previous), (Uint16)(FIRST_GLYPH + current));
+	}
+
+#ifdef __DEBUG
+	debug("GraphicsEngine::getGlyphAtlas() built atlas, height", rowY + rowH);
+#endif
+
+	return &atlas;
+}
+
+void GraphicsEngine::beginSpriteBatch() {
+	if (batching)
+		flushSpriteBatch();
+
+	batching = true;
+	batchTexture = nullptr;
+}
+
+void GraphicsEngine::drawSprite(SDL_Texture* texture, const SDL_Rect& src, const SDL_Rect& dst, const double& angle, SDL_RendererFlip flip, const SDL_Color& color) {
+	SpriteQuad quad = { src, dst, angle, flip, color };
+	if (!batching) {
+		copySprite(texture, quad);
+		return;
+	}
+
+	// a texture change ends the current run, so overlapping sprites keep their order
+	if (texture != batchTexture) {
+		flushSpriteBatch();
+		batchTexture = texture;
+	}
+
+	batchQuads.push_back(quad);
+}
+
+void GraphicsEngine::endSpriteBatch() {
+	flushSpriteBatch();
+	batching = false;
+	batchTexture = nullptr;
+}
+
+void GraphicsEngine::flushSpriteBatch() {
+	if (batchQuads.empty())
+		return;
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+	int textureW = 1, textureH = 1;
+	SDL_QueryTexture(batchTexture, 0, 0, &textureW, &textureH);
+	float invW = 1.0f / textureW, invH = 1.0f / textureH;
+
+	batchVertices.clear();
+	batchIndices.clear();
+	for (const SpriteQuad& quad : batchQuads) {
+		float u0 = quad.src.x * invW, u1 = (quad.src.x + quad.src.w) * invW;
+		float v0 = quad.src.y * invH, v1 = (quad.src.y + quad.src.h) * invH;
+		if (quad.flip & SDL_FLIP_HORIZONTAL) std::swap(u0, u1);
+		if (quad.flip & SDL_FLIP_VERTICAL) std::swap(v0, v1);
+
+		// corners relative to the centre of dst, rotated the same way SDL_RenderCopyEx does
+		float halfW = quad.dst.w * 0.5f, halfH = quad.dst.h * 0.5f;
+		float centerX = quad.dst.x + halfW, centerY = quad.dst.y + halfH;
+		float cosA = 1.0f, sinA = 0.0f;
+		if (quad.angle != 0.0) {
+			cosA = (float)cos(quad.angle * PI_OVER_180);
+			sinA = (float)sin(quad.angle * PI_OVER_180);
+		}
+		const float cornersX[4] = { -halfW, halfW, halfW, -halfW };
+		const float cornersY[4] = { -halfH, -halfH, halfH, halfH };
+		const float us[4] = { u0, u1, u1, u0 };
+		const float vs[4] = { v0, v0, v1, v1 };
+
+		int base = (int)batchVertices.size();
+		for (int i = 0; i < 4; ++i) {
+			SDL_Vertex vertex;
+			vertex.position.x = centerX + cornersX[i] * cosA - cornersY[i] * sinA;
+			vertex.position.y = centerY + cornersX[i] * sinA + cornersY[i] * cosA;
+			vertex.color = quad.color;
+			vertex.tex_coord.x = us[i];
+			vertex.tex_coord.y = vs[i];
+			batchVertices.push_back(vertex);
+		}
+		const int quadIndices[6] = { 0, 1, 2, 0, 2, 3 };
+		for (int index : quadIndices)
+			batchIndices.push_back(base + index);
+	}
+
+	SDL_RenderGeometry(renderer, batchTexture, batchVertices.data(), (int)batchVertices.size(), batchIndices.data(), (int)batchIndices.size());
+	++drawCalls;
+#else
+	// SDL older than 2.0.18 has no geometry API, submit the run quad by quad
+	for (const SpriteQuad& quad : batchQuads)
+		copySprite(batchTexture, quad);
+#endif
+
+	batchQuads.clear();
+}
+
+void GraphicsEngine::copySprite(SDL_Texture* texture, const SpriteQuad& quad) {
+	bool tinted = quad.color.r != 255 || quad.color.g != 255 || quad.color.b != 255 || quad.color.a != 255;
+	if (tinted) {
+		SDL_SetTextureColorMod(texture, quad.color.r, quad.color.g, quad.color.b);
+		SDL_SetTextureAlphaMod(texture, quad.color.a);
+	}
+
+	SDL_RenderCopyEx(renderer, texture, &quad.src, &quad.dst, quad.angle, nullptr, quad.flip);
+	++drawCalls;
+
+	if (tinted) {
+		SDL_SetTextureColorMod(texture, 255, 255, 255);
+		SDL_SetTextureAlphaMod(texture, 255);
+	}
+}
+
+TextLabel::TextLabel(const SDL_Color& color) : value(0), hasValue(false), color(color), font(nullptr), texture(nullptr), dirty(true) {}
+
+TextLabel::~TextLabel() {
+	if (texture != nullptr)
+		SDL_DestroyTexture(texture);
+}
+
+void TextLabel::setText(const std::string& _text) {
+	hasValue = false;
+	if (text == _text)
+		return;
+
+	text = _text;
+	dirty = true;
+}
+
+void TextLabel::setText(const char* _prefix, const int& _value) {
+	if (hasValue && value == _value && prefix == _prefix)
+		return;
+
+	prefix = _prefix;
+	value = _value;
+	hasValue = true;
+	text = prefix + std::to_string(value);
+	dirty = true;
+}
+
+void TextLabel::setColor(const SDL_Color& _color) {
+	if (color.r == _color.r && color.g == _color.g && color.b == _color.b && color.a == _color.a)
+		return;
+
+	color = _color;
+	dirty = true;
+}
@@ -3,6 +3,8 @@
 
 #include <string>
 #include <memory>
+#include <vector>
+#include <map>
 #include <iostream>
 
 #include <SDL.h>
@@ -48,6 +50,52 @@ inline SDL_Color toSDLColor(Uint8 r, Uint8 g, Uint8 b, Uint8 a) {
 	return color;
 }
 
+/**
+* Frame times in milliseconds over the recent frames, measured from one
+* setFrameStart() to the next so waiting for vsync or the frame cap is included
+*/
+struct FrameTimeStats {
+	double average, p50, p95, p99, max;
+	int frames;
+};
+
+/**
+* Text kept in its own texture between frames
+* The texture is only rebuilt when the text, color or font changes,
+* so a HUD string that rarely changes costs one copy per frame.
+* Destroy labels before the graphics engine
+*/
+class TextLabel {
+	friend class GraphicsEngine;
+private:
+	std::string text;
+	std::string prefix;
+	int value;
+	bool hasValue;
+	SDL_Color color;
+	TTF_Font* font;
+	SDL_Texture* texture;
+	Dimension2i size;
+	bool dirty;
+
+public:
+	TextLabel(const SDL_Color& color = SDL_COLOR_WHITE);
+	~TextLabel();
+	TextLabel(const TextLabel&) = delete;
+	TextLabel& operator=(const TextLabel&) = delete;
+
+	void setText(const std::string&);
+
+	/**
+	* Sets text to prefix followed by value
+	* Nothing is allocated while prefix and value stay the same
+	*/
+	void setText(const char* prefix, const int& value);
+	void setColor(const SDL_Color&);
+
+	const std::string& getText() { return text; }
+};
+
 class GraphicsEngine {
 	friend class XCube2Engine;
 private:
@@ -57,7 +105,55 @@ private:
 
 	TTF_Font* font;
 
-	Uint32 fpsAverage, fpsPrevious, fpsStart, fpsEnd;
+	/* frame pacing, times are in performance counter ticks */
+	static const int FRAME_HISTORY = 240;
+	Uint64 frameStart, targetFrameTicks;
+	double frameTimes[FRAME_HISTORY];	// ring buffer of the last frame times in ms
+	int frameTimeCount, frameTimeIndex;
+
+	Uint32 drawCalls, lastFrameDrawCalls;
+
+	/* counts SDL_RENDER_TARGETS_RESET and SDL_RENDER_DEVICE_RESET, either wipes render target contents */
+	Uint32 renderTargetResets;
+	static int SDLCALL onRenderReset(void* userdata, SDL_Event* event);
+
+	struct SpriteQuad {
+		SDL_Rect src, dst;
+		double angle;
+		SDL_RendererFlip flip;
+		SDL_Color color;
+	};
+	bool batching;
+	SDL_Texture* batchTexture;
+	std::vector<SpriteQuad> batchQuads;
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+	std::vector<SDL_Vertex> batchVertices;
+	std::vector<int> batchIndices;
+#endif
+
+	void flushSpriteBatch();
+	void copySprite(SDL_Texture*, const SpriteQuad&);
+
+	/* printable ASCII, anything else is drawn as '?' */
+	static const int FIRST_GLYPH = 32;
+	static const int GLYPH_COUNT = 95;
+
+	/**
+	* Every printable glyph of one font rasterized once in white,
+	* strings are drawn as batched quads tinted with the draw color
+	*/
+	struct GlyphAtlas {
+		SDL_Texture* texture;
+		SDL_Rect glyphs[GLYPH_COUNT];
+		int offsets[GLYPH_COUNT];
+		int advances[GLYPH_COUNT];
+		std::vector<int> kerning;	// GLYPH_COUNT * GLYPH_COUNT, indexed [previous * GLYPH_COUNT + current]
+	};
+	std::map<TTF_Font*, GlyphAtlas> glyphAtlases;
+
+	GlyphAtlas* getGlyphAtlas(TTF_Font*);
+	void updateTextLabel(TextLabel&);
+	static int glyphIndex(char c);
 
 	GraphicsEngine();
 
@@ -72,6 +168,11 @@ public:
 	*/
 	void clearScreen();
 
+	/**
+	* Clears the current render target to given color, alpha included
+	*/
+	void clearScreen(const SDL_Color&);
+
 	/**
 	* Displays everything rendered on the screen
 	* Call this method after you have finished drawing
@@ -88,6 +189,11 @@ public:
 	void fillRect(SDL_Rect*);
 	void fillRect(const int& x, const int& y, const int& w, const int& h);
 
+	/**
+	* Fills count rectangles with the draw color in one draw call
+	*/
+	void fillRects(const SDL_Rect* rects, const int& count);
+
 	void drawPoint(const Point2&);
 	void drawLine(const Line2i&);
 	void drawLine(const Point2& start, const Point2& end);
@@ -97,6 +203,46 @@ public:
 	void drawTexture(SDL_Texture*, SDL_Rect* dst, SDL_RendererFlip flip = SDL_FLIP_NONE);
 	void drawText(const std::string& text, const int& x, const int& y);
 
+	/**
+	* @return size of text drawn with the current font, from cached glyph metrics
+	*/
+	Dimension2i getTextSize(const std::string& text);
+
+	/**
+	* Draws label with the current font, rebuilding its texture first if it changed
+	*/
+	void drawText(TextLabel& label, const int& x, const int& y);
+
+	/**
+	* @return size of label drawn with the current font
+	*/
+	Dimension2i getTextSize(TextLabel& label);
+
+	/**
+	* Starts collecting sprites drawn with drawSprite()
+	* Nothing else should be drawn until endSpriteBatch() is called
+	*/
+	void beginSpriteBatch();
+
+	/**
+	* Queues a sprite, rotated by angle degrees clockwise around the centre of dst
+	* Consecutive sprites using the same texture are submitted together,
+	* so draw order is kept and sprites sharing a sheet should be drawn in runs.
+	* Outside of a batch the sprite is drawn straight away
+	* The texture is modulated by color, white leaves it unchanged
+	*/
+	void drawSprite(SDL_Texture*, const SDL_Rect& src, const SDL_Rect& dst, const double& angle = 0.0, SDL_RendererFlip flip = SDL_FLIP_NONE, const SDL_Color& color = SDL_COLOR_WHITE);
+
+	/**
+	* Submits all queued sprites and stops batching
+	*/
+	void endSpriteBatch();
+
+	/**
+	* @return number of SDL draw calls made during the last presented frame
+	*/
+	Uint32 getDrawCallCount() { return lastFrameDrawCalls; }
+
 	void setDrawColor(const SDL_Color&);
 	void setDrawScale(const Vector2f&);	// not tested
 
@@ -133,13 +279,54 @@ public:
 	*/
 	Dimension2i getMaximumWindowSize();
 
+	/**
+	* Marks the start of a frame, the time since the previous start is recorded
+	*/
 	void setFrameStart();
-	void adjustFPSDelay(const Uint32&);
+
+	/**
+	* Caps the frame rate for adjustFPSDelay()
+	*
+	* @param fps - frames per second, 0 to leave pacing to vsync
+	*/
+	void setTargetFrameRate(const Uint32& fps);
+
+	/**
+	* Waits until the frame has lasted 1 / target frame rate seconds.
+	* Sleeps while more than a couple of milliseconds are left and spins for the rest,
+	* since SDL_Delay can oversleep by a whole scheduler tick
+	*/
+	void adjustFPSDelay();
+
+	/**
+	* @return frame time average and percentiles over the last FRAME_HISTORY frames
+	*/
+	FrameTimeStats getFrameTimeStats();
 	Uint32 getAverageFPS();
 
 	static SDL_Texture* createTextureFromSurface(SDL_Surface*);
 	static SDL_Texture* createTextureFromString(const std::string&, TTF_Font*, SDL_Color);
 
+	/**
+	* Creates a texture that can be drawn into after passing it to setRenderTarget()
+	* @return the texture, nullptr if render targets are not supported
+	*/
+	static SDL_Texture* createRenderTarget(const int& w, const int& h);
+
+	/**
+	* Redirects all drawing into texture, pass nullptr to draw to the window again
+	* Any queued sprites are submitted to the previous target first
+	*/
+	void setRenderTarget(SDL_Texture*);
+	bool isRenderTargetSupported() { return SDL_RenderTargetSupported(renderer) == SDL_TRUE; }
+
+	/**
+	* Number of times the renderer lost render target contents, after a resize or fullscreen
+	* toggle on some backends (D3D9), anything drawn into a render target must be drawn again
+	* when this changes
+	*/
+	Uint32 getRenderTargetResets() { return renderTargetResets; }
+
 	// ADDED
 	void setWindowFocus() { if (window) SDL_RaiseWindow(window); }						// bring window to front
 	void setWindowResizable() { if (window) SDL_SetWindowResizable(window, SDL_TRUE); }	// make window resizable
@@ -0,0 +1,180 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+
+/**
+* Shared by every task of one job and by the jobs waiting on it
+*/
+struct JobGroup {
+	std::function<void(size_t, size_t)> body;
+	size_t count, chunkSize;
+	std::atomic<size_t> remaining;	// tasks not finished yet
+	std::atomic<int> waitingOn;	// unfinished dependencies, one extra while the job is being set up
+	std::mutex mutex;	// guards finished and dependents
+	bool finished;
+	std::vector<JobHandle> dependents;
+};
+
+/* which scheduler and queue the current thread works on, workers set these once */
+static thread_local JobSystem* threadScheduler = nullptr;
+static thread_local int threadQueue = -1;
+
+JobSystem::JobSystem(const int& workerCount) : queuedTasks(0), running(true) {
+	int count = std::max(0, workerCount);
+	for (int i = 0; i <= count; ++i)
+		queues.push_back(std::unique_ptr<Queue>(new Queue()));
+
+	for (int i = 0; i < count; ++i)
+		workers.push_back(std::thread(&JobSystem::workerLoop, this, i));
+
+#ifdef __DEBUG
+	debug("JobSystem() workers:", count);
+#endif
+}
+
+JobSystem::~JobSystem() {
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		running = false;
+	}
+	wake.notify_all();
+	for (std::thread& worker : workers)
+		worker.join();
+}
+
+void JobSystem::workerLoop(const int& index) {
+	threadScheduler = this;
+	threadQueue = index;
+	while (running) {
+		if (runTask(index))
+			continue;
+
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		wake.wait(lock, [this] { return !running || queuedTasks > 0; });
+	}
+}
+
+int JobSystem::currentQueue() {
+	return threadScheduler == this ? threadQueue : (int)queues.size() - 1;
+}
+
+bool JobSystem::runTask(const int& queue) {
+	Task task;
+	bool found = false;
+
+	// newest of our own first, it is likely still in cache
+	{
+		Queue& own = *queues[queue];
+		std::lock_guard<std::mutex> lock(own.mutex);
+		if (!own.tasks.empty()) {
+			task = std::move(own.tasks.back());
+			own.tasks.pop_back();
+			found = true;
+		}
+	}
+
+	// then the oldest of someone else's
+	for (size_t i = 1; !found && i < queues.size(); ++i) {
+		Queue& other = *queues[(queue + i) % queues.size()];
+		std::lock_guard<std::mutex> lock(other.mutex);
+		if (!other.tasks.empty()) {
+			task = std::move(other.tasks.front());
+			other.tasks.pop_front();
+			found = true;
+		}
+	}
+
+	if (!found)
+		return false;
+
+	--queuedTasks;
+	task.job->body(task.begin, task.end);
+	if (task.job->remaining.fetch_sub(1) == 1)
+		complete(task.job);
+	return true;
+}
+
+void JobSystem::release(const JobHandle& job) {
+	if (0 == job->remaining) {
+		complete(job);
+		return;
+	}
+
+	// chunks go to the releasing thread's queue, idle workers steal them from there
+	Queue& queue = *queues[currentQueue()];
+	int tasks = 0;
+	{
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		for (size_t begin = 0; begin < job->count; begin += job->chunkSize, ++tasks)
+			queue.tasks.push_back(Task{ job, begin, std::min(begin + job->chunkSize, job->count) });
+	}
+	queuedTasks += tasks;
+
+	// taking the lock means no worker is between checking queuedTasks and going to sleep
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+	}
+	if (tasks > 1)
+		wake.notify_all();
+	else
+		wake.notify_one();
+}
+
+void JobSystem::complete(const JobHandle& job) {
+	std::vector<JobHandle> dependents;
+	{
+		std::lock_guard<std::mutex> lock(job->mutex);
+		job->finished = true;
+		dependents.swap(job->dependents);
+	}
+	job->body = nullptr;	// drop whatever the tasks captured
+
+	for (const JobHandle& dependent : dependents)
+		if (dependent->waitingOn.fetch_sub(1) == 1)
+			release(dependent);
+}
+
+JobHandle JobSystem::schedule(std::function<void()> task, const std::vector<JobHandle>& dependencies) {
+	return parallelFor(1, 1, [task](size_t, size_t) { task(); }, dependencies);
+}
+
+JobHandle JobSystem::parallelFor(const size_t& count, const size_t& chunkSize, std::function<void(size_t, size_t)> body, const std::vector<JobHandle>& dependencies) {
+	JobHandle job = std::make_shared<JobGroup>();
+	job->body = std::move(body);
+	job->count = count;
+	job->chunkSize = std::max<size_t>(1, chunkSize);
+	job->remaining = (count + job->chunkSize - 1) / job->chunkSize;
+	job->finished = false;
+	job->waitingOn = 1;
+
+	for (const JobHandle& dependency : dependencies) {
+		if (!dependency)
+			continue;
+
+		std::lock_guard<std::mutex> lock(dependency->mutex);
+		if (!dependency->finished) {
+			dependency->dependents.push_back(job);
+			++job->waitingOn;
+		}
+	}
+
+	// drop the set up reference, whichever dependency finishes last releases the job otherwise
+	if (job->waitingOn.fetch_sub(1) == 1)
+		release(job);
+	return job;
+}
+
+void JobSystem::wait(const JobHandle& job) {
+	int queue = currentQueue();
+	while (!isFinished(job))
+		if (!runTask(queue))
+			std::this_thread::yield();
+}
+
+bool JobSystem::isFinished(const JobHandle& job) {
+	if (!job)
+		return true;
+
+	std::lock_guard<std::mutex> lock(job->mutex);
+	return job->finished;
+}
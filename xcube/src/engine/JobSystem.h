@@ -0,0 +1,81 @@
+#ifndef __JOB_SYSTEM_H__
+#define __JOB_SYSTEM_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "EngineCommon.h"
+
+struct JobGroup;	// defined in JobSystem.cpp
+typedef std::shared_ptr<JobGroup> JobHandle;
+
+/**
+* Work stealing job scheduler
+*
+* Every worker thread, and the thread that created the scheduler, owns a deque of tasks.
+* A thread pushes and pops at the back of its own deque and, once that is empty,
+* steals from the front of the others, so an idle thread takes the oldest work first.
+* A job is one or more tasks behind one handle, started once every job it depends on
+* has finished, which is how systems are ordered into a graph.
+* wait() runs queued tasks until the job is done, so a job may wait on other jobs
+* without tying up a thread. With no workers every task runs inside wait()
+*/
+class JobSystem {
+	friend class XCube2Engine;
+	private:
+		struct Task {
+			JobHandle job;
+			size_t begin, end;
+		};
+
+		struct Queue {
+			std::mutex mutex;
+			std::deque<Task> tasks;
+		};
+
+		std::vector<std::unique_ptr<Queue>> queues;	// one per worker, the last one belongs to every other thread
+		std::vector<std::thread> workers;
+		std::mutex sleepMutex;
+		std::condition_variable wake;
+		std::atomic<int> queuedTasks;
+		std::atomic<bool> running;
+
+		JobSystem(const int& workerCount);
+
+		void workerLoop(const int& index);
+		int currentQueue();
+		bool runTask(const int& queue);	// pop or steal one task and run it, false if there was none
+		void release(const JobHandle& job);	// queue the tasks of a job whose dependencies have finished
+		void complete(const JobHandle& job);	// mark finished and release dependents
+
+	public:
+		~JobSystem();
+
+		int getWorkerCount() { return (int)workers.size(); }
+
+		/**
+		* Queues task to run once every job in dependencies has finished
+		*/
+		JobHandle schedule(std::function<void()> task, const std::vector<JobHandle>& dependencies = {});
+
+		/**
+		* Splits [0, count) into chunks of at most chunkSize and calls body(begin, end) for each,
+		* spread over the workers, once every job in dependencies has finished.
+		* body must be safe to run on several chunks at once. A job with count 0 finishes straight away
+		*/
+		JobHandle parallelFor(const size_t& count, const size_t& chunkSize, std::function<void(size_t, size_t)> body, const std::vector<JobHandle>& dependencies = {});
+
+		/**
+		* Runs queued tasks on the calling thread until job has finished
+		*/
+		void wait(const JobHandle& job);
+		bool isFinished(const JobHandle& job);
+};
+
+#endif
@@ -0,0 +1,215 @@
+#include "Profiler.h"
+
+#ifdef __PROFILE
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+
+Profiler::Slot Profiler::ring[Profiler::RING_SIZE];
+std::atomic<Uint32> Profiler::writeIndex(0);
+Uint32 Profiler::readIndex = 0;
+const char* Profiler::zoneNames[Profiler::MAX_ZONES];
+std::atomic<int> Profiler::zoneCount(0);
+const char* Profiler::counterNames[Profiler::MAX_COUNTERS];
+std::atomic<int> Profiler::counterCount(0);
+double Profiler::history[Profiler::MAX_ZONES][Profiler::HISTORY];
+int Profiler::historyIndex = 0;
+bool Profiler::overlayVisible = false;
+FILE* Profiler::traceFile = nullptr;
+Uint64 Profiler::traceStart = 0;
+Uint64 Profiler::frameStart = 0;
+
+static std::mutex zoneMutex;	// registration only, once per call site
+
+/* trace timestamps are microseconds since startTrace() */
+static double toMicroseconds(const Sint64& ticks) {
+	return ticks * 1000000.0 / SDL_GetPerformanceFrequency();
+}
+
+static const SDL_Color ZONE_COLORS[] = { SDL_COLOR_AQUA, SDL_COLOR_ORANGE, SDL_COLOR_GREEN, SDL_COLOR_PINK,
+	SDL_COLOR_YELLOW, SDL_COLOR_VIOLET, SDL_COLOR_RED, SDL_COLOR_WHITE };
+
+int Profiler::registerZone(const char* name) {
+	std::lock_guard<std::mutex> lock(zoneMutex);
+	int count = zoneCount.load(std::memory_order_relaxed);
+	for (int zone = 0; zone < count; ++zone)
+		if (std::strcmp(zoneNames[zone], name) == 0)
+			return zone;
+
+	if (count >= MAX_ZONES) {
+#ifdef __DEBUG
+		debug("Profiler: too many zones, not timing", name);
+#endif
+		return -1;
+	}
+
+	zoneNames[count] = name;
+	for (int frame = 0; frame < HISTORY; ++frame)
+		history[count][frame] = 0.0;
+	zoneCount.store(count + 1, std::memory_order_release);
+	return count;
+}
+
+int Profiler::registerCounter(const char* name) {
+	std::lock_guard<std::mutex> lock(zoneMutex);
+	int count = counterCount.load(std::memory_order_relaxed);
+	for (int counter = 0; counter < count; ++counter)
+		if (std::strcmp(counterNames[counter], name) == 0)
+			return counter;
+
+	if (count >= MAX_COUNTERS) {
+#ifdef __DEBUG
+		debug("Profiler: too many counters, not recording", name);
+#endif
+		return -1;
+	}
+
+	counterNames[count] = name;
+	counterCount.store(count + 1, std::memory_order_release);
+	return count;
+}
+
+void Profiler::push(const Sample& sample) {
+	// claim a slot, then publish it; a writer that laps the reader overwrites the oldest samples
+	Uint32 index = writeIndex.fetch_add(1, std::memory_order_relaxed);
+	Slot& slot = ring[index & (RING_SIZE - 1)];
+	slot.sequence.store(0, std::memory_order_relaxed);	// mark the slot as being written before touching the sample
+	std::atomic_thread_fence(std::memory_order_release);
+	slot.sample = sample;
+	slot.sequence.store(index + 1, std::memory_order_release);
+}
+
+void Profiler::record(const int& zone, const Uint64& start, const Uint64& end) {
+	if (zone >= 0)
+		push(Sample{ zone, false, SDL_ThreadID(), start, (Sint64)(end - start) });
+}
+
+void Profiler::recordCounter(const int& counter, const Sint64& value) {
+	if (counter >= 0 && nullptr != traceFile)
+		push(Sample{ counter, true, SDL_ThreadID(), SDL_GetPerformanceCounter(), value });
+}
+
+void Profiler::endFrame() {
+	historyIndex = (historyIndex + 1) % HISTORY;
+	int count = zoneCount.load(std::memory_order_acquire);
+	for (int zone = 0; zone < count; ++zone)
+		history[zone][historyIndex] = 0.0;
+
+	Uint32 end = writeIndex.load(std::memory_order_acquire);
+	if (end - readIndex > RING_SIZE)
+		readIndex = end - RING_SIZE;	// fell behind, the older samples are gone
+
+	double msPerTick = 1000.0 / SDL_GetPerformanceFrequency();
+	for (; readIndex != end; ++readIndex) {
+		Slot& slot = ring[readIndex & (RING_SIZE - 1)];
+		if (slot.sequence.load(std::memory_order_acquire) != readIndex + 1)
+			break;	// still being written, picked up next frame
+
+		// copy, then check the slot was not reused by a writer that lapped the reader during the copy
+		Sample sample = slot.sample;
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (slot.sequence.load(std::memory_order_relaxed) != readIndex + 1)
+			continue;	// torn, this sample was overwritten and is gone
+		if (!sample.counter && sample.id < count)
+			history[sample.id][historyIndex] += sample.value * msPerTick;
+		if (nullptr != traceFile)
+			writeTraceEvent(sample);
+	}
+
+	if (nullptr != traceFile) {
+		// frame marker across all threads, then the frame itself as a zone on the main thread
+		Uint64 now = SDL_GetPerformanceCounter();
+		std::fprintf(traceFile, ",\n{\"name\":\"frame\",\"ph\":\"X\",\"pid\":1,\"tid\":%lu,\"ts\":%.3f,\"dur\":%.3f}",
+			(unsigned long)SDL_ThreadID(), toMicroseconds(frameStart - traceStart), toMicroseconds(now - frameStart));
+		std::fprintf(traceFile, ",\n{\"name\":\"frame end\",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":%lu,\"ts\":%.3f}",
+			(unsigned long)SDL_ThreadID(), toMicroseconds(now - traceStart));
+		frameStart = now;
+	}
+}
+
+bool Profiler::startTrace(const std::string& fileName) {
+	stopTrace();
+	traceFile = std::fopen(fileName.c_str(), "w");
+	if (nullptr == traceFile) {
+#ifdef __DEBUG
+		debug("Profiler: failed to open trace file", fileName.c_str());
+#endif
+		return false;
+	}
+
+	// samples queued before the trace started have no place in it
+	readIndex = writeIndex.load(std::memory_order_acquire);
+	traceStart = frameStart = SDL_GetPerformanceCounter();
+	std::fprintf(traceFile, "[\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%lu,\"args\":{\"name\":\"main\"}}",
+		(unsigned long)SDL_ThreadID());
+	return true;
+}
+
+void Profiler::stopTrace() {
+	if (nullptr == traceFile)
+		return;
+
+	endFrame();	// whatever is still queued
+	std::fprintf(traceFile, "\n]\n");
+	std::fclose(traceFile);
+	traceFile = nullptr;
+}
+
+void Profiler::writeTraceEvent(const Sample& sample) {
+	if (sample.start < traceStart)
+		return;
+
+	if (sample.counter) {
+		std::fprintf(traceFile, ",\n{\"name\":\"%s\",\"ph\":\"C\",\"pid\":1,\"tid\":%lu,\"ts\":%.3f,\"args\":{\"value\":%lld}}",
+			counterNames[sample.id], (unsigned long)sample.thread, toMicroseconds(sample.start - traceStart), (long long)sample.value);
+	}
+	else {
+		std::fprintf(traceFile, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%lu,\"ts\":%.3f,\"dur\":%.3f}",
+			zoneNames[sample.id], (unsigned long)sample.thread, toMicroseconds(sample.start - traceStart), toMicroseconds(sample.value));
+	}
+}
+
+void Profiler::drawOverlay(std::shared_ptr<GraphicsEngine> gfx) {
+	int count = zoneCount.load(std::memory_order_acquire);
+	if (!overlayVisible || !gfx || 0 == count)
+		return;
+
+	static const double FRAME_BUDGET_MS = 1000.0 / 60.0;
+	static const int BAR_WIDTH = 2, PADDING = 4;
+
+	int rowHeight = std::max(12, gfx->getTextSize("Ag").h);
+	int nameWidth = 0;
+	for (int zone = 0; zone < count; ++zone)
+		nameWidth = std::max(nameWidth, gfx->getTextSize(zoneNames[zone]).w);
+	int valueWidth = gfx->getTextSize("00.00").w;
+	int graphX = PADDING * 3 + nameWidth + valueWidth;
+	int x = PADDING, y = rowHeight * 3;
+
+	SDL_Color background = SDL_COLOR_BLACK;
+	background.a = 160;
+	gfx->setDrawColor(background);
+	gfx->fillRect(x, y, graphX + HISTORY * BAR_WIDTH + PADDING, count * rowHeight + PADDING * 2);
+
+	SDL_Rect bars[HISTORY];
+	char value[16];
+	for (int zone = 0; zone < count; ++zone) {
+		int rowY = y + PADDING + zone * rowHeight;
+		const SDL_Color& color = ZONE_COLORS[zone % (sizeof(ZONE_COLORS) / sizeof(ZONE_COLORS[0]))];
+		gfx->setDrawColor(color);
+		gfx->drawText(zoneNames[zone], x + PADDING, rowY);
+		SDL_snprintf(value, sizeof(value), "%.2f", history[zone][historyIndex]);
+		gfx->drawText(value, x + PADDING * 2 + nameWidth + valueWidth - gfx->getTextSize(value).w, rowY);
+
+		// oldest frame on the left, bars grow up from the bottom of the row
+		int graphHeight = rowHeight - 2;
+		for (int frame = 0; frame < HISTORY; ++frame) {
+			double ms = history[zone][(historyIndex + 1 + frame) % HISTORY];
+			int height = (int)(std::min(ms / FRAME_BUDGET_MS, 1.0) * graphHeight + 0.5);
+			bars[frame] = { x + graphX + frame * BAR_WIDTH, rowY + rowHeight - 1 - height, BAR_WIDTH, height };
+		}
+		gfx->fillRects(bars, (int)HISTORY);	// by value, HISTORY has no out of class definition
+	}
+}
+
+#endif
@@ -0,0 +1,159 @@
+#ifndef __PROFILER_H__
+#define __PROFILER_H__
+
+#include "EngineCommon.h"
+
+#ifdef __PROFILE
+
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <string>
+
+#include "GraphicsEngine.h"
+
+/**
+* Scoped timing zones, compiled in only when __PROFILE is defined (see EngineCommon.h)
+*
+* PROFILE_ZONE("name") times the rest of the enclosing scope. Zones with the same name
+* are added together, so a zone entered several times in a frame shows its total.
+* Finished zones are pushed into a lock-free ring buffer, which any thread may write,
+* and endFrame() drains it once per frame into per-zone milliseconds
+* for the last HISTORY frames, drawn by drawOverlay()
+*
+* While a trace is running, endFrame() also appends every zone, counter and frame marker
+* to a file in the Chrome trace event format, which chrome://tracing and ui.perfetto.dev open.
+* Zones are complete ("X") events on the thread that ran them, counters are "C" events
+*/
+class Profiler {
+	public:
+		static const int MAX_ZONES = 32;
+		static const int MAX_COUNTERS = 16;
+		static const int HISTORY = 120;	// frames kept per zone, each one a 2 pixel wide bar in the overlay
+
+		/**
+		* @return id of the zone called name, registered on first use
+		*         -1 once MAX_ZONES zones exist
+		*/
+		static int registerZone(const char* name);
+
+		/**
+		* Queues one run of zone, times are performance counter ticks
+		* Safe to call from any thread, never blocks
+		*/
+		static void record(const int& zone, const Uint64& start, const Uint64& end);
+
+		/**
+		* @return id of the counter called name, registered on first use
+		*         -1 once MAX_COUNTERS counters exist
+		*/
+		static int registerCounter(const char* name);
+
+		/**
+		* Queues the current value of counter, only written to traces
+		* Safe to call from any thread, never blocks
+		*/
+		static void recordCounter(const int& counter, const Sint64& value);
+
+		/**
+		* Totals the runs queued since the last call as the frame that just finished
+		* Call once per frame on the main thread
+		*/
+		static void endFrame();
+
+		/**
+		* Starts writing trace events to fileName, replacing any trace already running
+		* @return false if the file could not be opened
+		*/
+		static bool startTrace(const std::string& fileName);
+
+		/**
+		* Finishes the trace file, safe to call when no trace is running
+		*/
+		static void stopTrace();
+		static bool isTracing() { return nullptr != traceFile; }
+
+		static void toggleOverlay() { overlayVisible = !overlayVisible; }
+		static bool isOverlayVisible() { return overlayVisible; }
+
+		/**
+		* Draws one row per zone with its name, the last frame's milliseconds
+		* and a graph of the last HISTORY frames, the top of each graph being one 60 Hz frame.
+		* Does nothing while the overlay is hidden
+		*/
+		static void drawOverlay(std::shared_ptr<GraphicsEngine> gfx);
+
+	private:
+		/* zone runs and counter values share the ring so traces see them in order */
+		struct Sample {
+			int id;
+			bool counter;
+			SDL_threadID thread;
+			Uint64 start;
+			Sint64 value;	// ticks the zone ran for, or the counter value
+		};
+
+		static void push(const Sample& sample);
+		static void writeTraceEvent(const Sample& sample);
+
+		/* sequence is the write index + 1 once sample is complete and 0 while it is being written,
+   so the reader can tell a slot still being written and re-check it after copying the sample */
+		struct Slot {
+			std::atomic<Uint32> sequence;
+			Sample sample;
+		};
+
+		static const Uint32 RING_SIZE = 8192;	// power of two, several frames of zones
+
+		static Slot ring[RING_SIZE];
+		static std::atomic<Uint32> writeIndex;
+		static Uint32 readIndex;
+
+		static const char* zoneNames[MAX_ZONES];
+		static std::atomic<int> zoneCount;
+		static const char* counterNames[MAX_COUNTERS];
+		static std::atomic<int> counterCount;
+
+		static double history[MAX_ZONES][HISTORY];	// ms per frame, ring indexed by historyIndex
+		static int historyIndex;
+		static bool overlayVisible;
+
+		static FILE* traceFile;
+		static Uint64 traceStart;
+		static Uint64 frameStart;
+};
+
+class ProfileZone {
+	private:
+		int zone;
+		Uint64 start;
+
+	public:
+		explicit ProfileZone(const int& zone) : zone(zone), start(SDL_GetPerformanceCounter()) {}
+		~ProfileZone() { Profiler::record(zone, start, SDL_GetPerformanceCounter()); }
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+/* the zone id is looked up once per call site, the timer lives until the end of the scope,
+   without __PROFILE (release builds) the macro expands to nothing */
+#define PROFILE_ZONE(name) \
+	static const int PROFILE_CONCAT(profileZoneId, __LINE__) = Profiler::registerZone(name); \
+	ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(PROFILE_CONCAT(profileZoneId, __LINE__))
+
+/* value is not evaluated when profiling is compiled out */
+#define PROFILE_COUNTER(name, value) \
+	do { \
+		static const int profileCounterId = Profiler::registerCounter(name); \
+		Profiler::recordCounter(profileCounterId, (Sint64)(value)); \
+	} while (0)
+
+#else
+
+#define PROFILE_ZONE(name)
+#define PROFILE_COUNTER(name, value) do {} while (0)
+
+#endif
+
+#endif
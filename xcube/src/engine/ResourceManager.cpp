@@ -1,28 +1,438 @@
 #include "ResourceManager.h"
 
+#include <algorithm>
+#include <cstdlib>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <exception>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+
 std::map<std::string, SDL_Texture *> ResourceManager::textures;
+std::map<std::string, int> ResourceManager::textureReferences;
+std::map<std::string, SDL_Surface *> ResourceManager::keptSurfaces;
 std::map<std::string, TTF_Font *> ResourceManager::fonts;
 std::map<std::string, Mix_Chunk *> ResourceManager::sounds;
 std::map<std::string, Mix_Music *> ResourceManager::mp3files;
+const Uint8 * ResourceManager::archiveData = nullptr;
+size_t ResourceManager::archiveSize = 0;
+void * ResourceManager::archiveFile = nullptr;
+void * ResourceManager::archiveMapping = nullptr;
+std::map<std::string, const AssetEntry *> ResourceManager::archiveEntries;
 
-SDL_Texture * ResourceManager::loadTexture(std::string file, SDL_Color trans) {
-	SDL_Texture * texture = nullptr;
+/**
+* One queued file, shared by every request for the same resource while it is in flight
+*/
+struct AsyncLoad {
+	std::string fileName, key;
+	SDL_Color transparent;
+	bool isSound;
+	SDL_Surface * surface = nullptr;	// decoded on a worker, uploaded on the render thread
+	Mix_Chunk * chunk = nullptr;
+	std::vector<std::function<void(SDL_Texture *)>> onTexture;
+	std::vector<std::function<void(Mix_Chunk *)>> onSound;
+	bool reload = false;	// replaces an already loaded resource, not counted as loading
+	bool keepSurface = false;	// keep the decoded image for loadTextureAtlas once uploaded
+	std::exception_ptr error;	// why decoding failed, rethrown on the render thread
+
+	AsyncLoad(const std::string & fileName, const std::string & key, const SDL_Color & transparent, const bool & isSound)
+		: fileName(fileName), key(key), transparent(transparent), isSound(isSound) {}
+};
+
+/**
+* Worker threads and the two queues between them and the render thread,
+* only the queues are shared, everything else is touched by the render thread alone
+*/
+static struct AsyncLoader {
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::deque<std::shared_ptr<AsyncLoad>> requests;
+	std::deque<std::shared_ptr<AsyncLoad>> decoded;
+	bool stopping = false;
+
+	std::map<std::string, std::shared_ptr<AsyncLoad>> inFlight;
+	Uint32 requested = 0, completed = 0;
+
+	~AsyncLoader() {
+		// freeResources() normally stops the workers, a running std::thread must not be destroyed
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		wake.notify_all();
+		for (std::thread & worker : workers)
+			worker.join();
+	}
+} asyncLoader;
+
+/**
+* Image packed into an atlas page, kept so a changed file can be copied into its region
+*/
+struct AtlasImage {
+	std::string fileName;
+	SDL_Color transparent;
+	AtlasRegion region;
+};
+
+/**
+* Watched files and how changes to them are noticed, touched by the render thread only
+*/
+static struct HotReload {
+	bool enabled = false;
+	int notifyFd = -1;	// inotify instance, -1 where modification times are polled instead
+	std::map<int, std::string> directories;	// inotify watch to directory prefix of its files
+	std::map<std::string, time_t> files;	// watched file to its last modification time
+	std::vector<AtlasImage> atlasImages;
+	std::function<void(SDL_Texture *, SDL_Texture *)> onTextureReloaded;
+	Uint32 lastPoll = 0;
+} hotReload;
+
+static time_t modificationTime(const std::string & file) {
+	struct stat fileStat;
+	return stat(file.c_str(), &fileStat) == 0 ? fileStat.st_mtime : 0;
+}
+
+/**
+* Copies surf into rect of texture, converting it to the texture's format first
+*/
+static bool updateTexture(SDL_Texture * texture, const SDL_Rect * rect, SDL_Surface * surf) {
+	Uint32 format = 0;
+	if (SDL_QueryTexture(texture, &format, nullptr, nullptr, nullptr) != 0)
+		return false;
+
+	SDL_Surface * converted = surf->format->format == format ? surf : SDL_ConvertSurfaceFormat(surf, format, 0);
+	if (nullptr == converted)
+		return false;
+	bool updated = SDL_UpdateTexture(texture, rect, converted->pixels, converted->pitch) == 0;
+	if (converted != surf)
+		SDL_FreeSurface(converted);
+	return updated;
+}
+
+bool ResourceManager::loadArchive(std::string file) {
+	if (archiveData != nullptr) {
+		std::cout << "An archive is already loaded, ignoring: " << file << std::endl;
+		return false;
+	}
+
+#ifdef _WIN32
+	HANDLE fileHandle = CreateFileA(file.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (INVALID_HANDLE_VALUE == fileHandle)
+		return false;
+
+	LARGE_INTEGER fileSize;
+	HANDLE mappingHandle = nullptr;
+	if (GetFileSizeEx(fileHandle, &fileSize) && fileSize.QuadPart > 0)
+		mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	const void * view = mappingHandle ? MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0) : nullptr;
+	if (nullptr == view) {
+		if (mappingHandle)
+			CloseHandle(mappingHandle);
+		CloseHandle(fileHandle);
+		return false;
+	}
+
+	archiveFile = fileHandle;
+	archiveMapping = mappingHandle;
+	archiveSize = (size_t)fileSize.QuadPart;
+#else
+	int fd = open(file.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat fileStat;
+	void * view = MAP_FAILED;
+	if (fstat(fd, &fileStat) == 0 && fileStat.st_size > 0)
+		view = mmap(nullptr, (size_t)fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);	// the mapping keeps the file alive
+	if (MAP_FAILED == view)
+		return false;
+
+	archiveSize = (size_t)fileStat.st_size;
+#endif
+	archiveData = (const Uint8 *)view;
+
+	// validate everything up front so lookups can trust the table
+	const AssetArchiveHeader * header = (const AssetArchiveHeader *)archiveData;
+	if (archiveSize < sizeof(AssetArchiveHeader) || header->magic != ASSET_ARCHIVE_MAGIC || header->version != ASSET_ARCHIVE_VERSION
+		|| (archiveSize - sizeof(AssetArchiveHeader)) / sizeof(AssetEntry) < header->entryCount) {
+		closeArchive();
+		std::cout << "Invalid asset archive, using loose files: " << file << std::endl;
+		return false;
+	}
+
+	const AssetEntry * entries = (const AssetEntry *)(archiveData + sizeof(AssetArchiveHeader));
+	for (Uint32 i = 0; i < header->entryCount; ++i) {
+		const AssetEntry & entry = entries[i];
+		bool valid = entry.name[ASSET_NAME_LENGTH - 1] == '\0' && entry.offset <= archiveSize && entry.size <= archiveSize - entry.offset
+			&& (entry.type != ASSET_IMAGE || (Uint64)entry.width * entry.height * 4 == entry.size);
+		if (!valid) {
+			closeArchive();
+			std::cout << "Corrupt entry in asset archive, using loose files: " << file << std::endl;
+			return false;
+		}
+		archiveEntries[entry.name] = &entry;
+	}
+
+#ifdef __DEBUG
+	debug("Archive loaded:", file.c_str());
+	debug("Archive entries:", (int)header->entryCount);
+#endif
+
+	return true;
+}
+
+void ResourceManager::closeArchive() {
+	if (nullptr == archiveData)
+		return;
+
+	archiveEntries.clear();
+#ifdef _WIN32
+	UnmapViewOfFile(archiveData);
+	CloseHandle((HANDLE)archiveMapping);
+	CloseHandle((HANDLE)archiveFile);
+	archiveMapping = archiveFile = nullptr;
+#else
+	munmap((void *)archiveData, archiveSize);
+#endif
+	archiveData = nullptr;
+	archiveSize = 0;
+}
+
+SDL_Surface * ResourceManager::loadSurface(const std::string & file, const bool & useArchive) {
+	auto found = archiveEntries.find(file);
+	if (useArchive && found != archiveEntries.end() && found->second->type == ASSET_IMAGE) {
+		// the surface reads straight from the mapping, nothing is decoded or copied
+		const AssetEntry * entry = found->second;
+		SDL_Surface * surf = SDL_CreateRGBSurfaceWithFormatFrom((void *)(archiveData + entry->offset), (int)entry->width, (int)entry->height,
+			32, (int)entry->width * 4, SDL_PIXELFORMAT_RGBA32);
+		if (nullptr == surf)
+			throw EngineException(SDL_GetError(), file);
+		return surf;
+	}
 
 	SDL_Surface * surf = IMG_Load(file.c_str());
 	if (nullptr == surf)
 		throw EngineException(IMG_GetError(), file);
+	return surf;
+}
+
+std::string ResourceManager::textureKey(const std::string & file, const SDL_Color & trans) {
+	char color[8];
+	SDL_snprintf(color, sizeof(color), "#%02X%02X%02X", trans.r, trans.g, trans.b);
+	return file + color;
+}
+
+SDL_Texture * ResourceManager::loadTexture(std::string file, SDL_Color trans, const bool & keepSurface) {
+	std::string key = textureKey(file, trans);
+	auto cached = textures.find(key);
+	if (cached != textures.end() && cached->second != nullptr) {
+		++textureReferences[key];
+		return cached->second;
+	}
+
+	SDL_Texture * texture = nullptr;
+
+	SDL_Surface * surf = loadSurface(file);
 
 	SDL_SetColorKey(surf, SDL_TRUE, SDL_MapRGB(surf->format, trans.r, trans.g, trans.b));
 	
 	texture = GFX::createTextureFromSurface(surf);
-	if (nullptr == texture)
+	if (nullptr == texture) {
+		SDL_FreeSurface(surf);
 		throw EngineException(SDL_GetError(), file);
+	}
+	if (keepSurface)
+		keptSurfaces[key] = surf;
+	else
+		SDL_FreeSurface(surf);
 
-	SDL_FreeSurface(surf);
+	textures[key] = texture;
+	textureReferences[key] = 1;
+	watchFile(file);
+#ifdef __DEBUG
+	debug("Texture loaded:", key.c_str());
+#endif
 
 	return texture;
 }
 
+void ResourceManager::releaseTexture(SDL_Texture * texture) {
+	if (nullptr == texture)
+		return;
+
+	for (auto it = textures.begin(); it != textures.end(); ++it) {
+		if (it->second != texture)
+			continue;
+
+		if (--textureReferences[it->first] <= 0) {
+			// a destroyed atlas page has nothing left to reload into
+			hotReload.atlasImages.erase(std::remove_if(hotReload.atlasImages.begin(), hotReload.atlasImages.end(),
+				[texture](const AtlasImage & image) { return image.region.texture == texture; }), hotReload.atlasImages.end());
+			SDL_DestroyTexture(texture);
+			freeKeptSurface(it->first);
+#ifdef __DEBUG
+			debug("Texture released:", it->first.c_str());
+#endif
+			textureReferences.erase(it->first);
+			textures.erase(it);
+		}
+		return;
+	}
+}
+
+void ResourceManager::freeKeptSurface(const std::string & key) {
+	auto kept = keptSurfaces.find(key);
+	if (kept == keptSurfaces.end())
+		return;
+
+	SDL_FreeSurface(kept->second);
+	keptSurfaces.erase(kept);
+}
+
+void ResourceManager::retainTexture(SDL_Texture * texture) {
+	for (auto & pair : textures) {
+		if (pair.second == texture) {
+			++textureReferences[pair.first];
+			return;
+		}
+	}
+}
+
+std::vector<AtlasRegion> ResourceManager::loadTextureAtlas(const std::vector<std::pair<std::string, SDL_Color>> & images, const int & pageSize) {
+	const int padding = 1;	// keeps filtered samples from reaching the neighbouring image
+	static int atlasCount = 0;
+	std::string atlasName = "atlas#" + std::to_string(atlasCount++) + "/";
+
+	std::vector<SDL_Surface *> surfaces;
+	auto freeSurfaces = [&]() {
+		for (SDL_Surface * surf : surfaces)
+			SDL_FreeSurface(surf);
+	};
+	for (auto & image : images) {
+		// take the image decoded when its texture was loaded if it was kept, it is freed with the others
+		SDL_Surface * surf = nullptr;
+		auto kept = keptSurfaces.find(textureKey(image.first, image.second));
+		if (kept != keptSurfaces.end()) {
+			surf = kept->second;
+			keptSurfaces.erase(kept);
+		}
+		else {
+			try {
+				surf = loadSurface(image.first);
+			}
+			catch (...) {
+				freeSurfaces();
+				throw;
+			}
+		}
+		SDL_SetColorKey(surf, SDL_TRUE, SDL_MapRGB(surf->format, image.second.r, image.second.g, image.second.b));
+		surfaces.push_back(surf);
+	}
+
+	// shelf packing, tallest images first so each shelf wastes little height
+	std::vector<size_t> order(images.size());
+	for (size_t i = 0; i < order.size(); ++i)
+		order[i] = i;
+	std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return surfaces[a]->h > surfaces[b]->h; });
+
+	std::vector<int> pages(images.size());
+	std::vector<SDL_Rect> rects(images.size());
+	std::vector<Dimension2i> pageSizes;
+	int page = -1, shelfX = 0, shelfY = 0, shelfH = 0;
+	for (size_t i : order) {
+		int w = surfaces[i]->w, h = surfaces[i]->h;
+		if (w > pageSize || h > pageSize) {
+			pages[i] = (int)pageSizes.size();
+			rects[i] = { 0, 0, w, h };
+			pageSizes.push_back(Dimension2i(w, h));
+			continue;
+		}
+
+		if (page >= 0 && shelfX + w > pageSize) {
+			shelfX = 0;
+			shelfY += shelfH + padding;
+			shelfH = 0;
+		}
+		if (page < 0 || shelfY + h > pageSize) {
+			page = (int)pageSizes.size();
+			pageSizes.push_back(Dimension2i(0, 0));
+			shelfX = shelfY = shelfH = 0;
+		}
+
+		pages[i] = page;
+		rects[i] = { shelfX, shelfY, w, h };
+		shelfX += w + padding;
+		shelfH = std::max(shelfH, h);
+		pageSizes[page].w = std::max(pageSizes[page].w, shelfX - padding);
+		pageSizes[page].h = std::max(pageSizes[page].h, shelfY + h);
+	}
+
+	std::vector<SDL_Texture *> pageTextures;
+	for (page = 0; page < (int)pageSizes.size(); ++page) {
+		SDL_Surface * pageSurf = SDL_CreateRGBSurfaceWithFormat(0, std::max(1, pageSizes[page].w), std::max(1, pageSizes[page].h), 32, SDL_PIXELFORMAT_RGBA32);
+		if (nullptr == pageSurf) {
+			freeSurfaces();
+			throw EngineException("Failed to create atlas page", SDL_GetError());
+		}
+
+		SDL_FillRect(pageSurf, nullptr, SDL_MapRGBA(pageSurf->format, 0, 0, 0, 0));
+		for (size_t i = 0; i < images.size(); ++i) {
+			if (pages[i] != page)
+				continue;
+			// color keyed pixels are skipped and stay transparent, the rest is copied as is
+			SDL_SetSurfaceBlendMode(surfaces[i], SDL_BLENDMODE_NONE);
+			SDL_Rect dst = rects[i];
+			SDL_BlitSurface(surfaces[i], nullptr, pageSurf, &dst);
+		}
+
+		SDL_Texture * texture = GFX::createTextureFromSurface(pageSurf);
+		SDL_FreeSurface(pageSurf);
+		if (nullptr == texture) {
+			freeSurfaces();
+			throw EngineException("Failed to create atlas page", SDL_GetError());
+		}
+		SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+
+		std::string key = atlasName + std::to_string(page);
+		textures[key] = texture;
+		textureReferences[key] = 0;
+		pageTextures.push_back(texture);
+#ifdef __DEBUG
+		debug("Atlas page created:", key.c_str());
+#endif
+	}
+
+	freeSurfaces();
+
+	std::vector<AtlasRegion> regions(images.size());
+	for (size_t i = 0; i < images.size(); ++i) {
+		regions[i] = { pageTextures[pages[i]], rects[i] };
+		hotReload.atlasImages.push_back({ images[i].first, images[i].second, regions[i] });
+		watchFile(images[i].first);
+	}
+	return regions;
+}
+
 TTF_Font * ResourceManager::loadFont(std::string file, const int & pt) {
 	TTF_Font * font = TTF_OpenFont(file.c_str(), pt);
 	if (nullptr == font)
@@ -32,13 +442,462 @@ TTF_Font * ResourceManager::loadFont(std::string file, const int & pt) {
 }
 
 Mix_Chunk * ResourceManager::loadSound(std::string file) {
-	Mix_Chunk * sound = Mix_LoadWAV(file.c_str());
+	Mix_Chunk * sound = decodeSound(file);
+	sounds[file] = sound;
+	watchFile(file);
+	return sound;
+}
+
+Mix_Chunk * ResourceManager::decodeSound(const std::string & file, const bool & useArchive) {
+	Mix_Chunk * sound = nullptr;
+
+	// cooked PCM is played from the mapping if it matches the format the mixer was opened with
+	auto found = archiveEntries.find(file);
+	int frequency = 0, channels = 0;
+	Uint16 format = 0;
+	if (useArchive && found != archiveEntries.end() && found->second->type == ASSET_SOUND && Mix_QuerySpec(&frequency, &format, &channels)
+		&& found->second->frequency == (Uint32)frequency && found->second->format == format && found->second->channels == channels)
+		sound = Mix_QuickLoad_RAW((Uint8 *)(archiveData + found->second->offset), (Uint32)found->second->size);
+
+	if (nullptr == sound)
+		sound = Mix_LoadWAV(file.c_str());
 	if (nullptr == sound)
 		throw EngineException(Mix_GetError(), file);
-	sounds[file] = sound;
 	return sound;
 }
 
+void ResourceManager::loadTextureAsync(std::string file, SDL_Color trans, std::function<void(SDL_Texture *)> onLoaded, const bool & keepSurface) {
+	std::string key = textureKey(file, trans);
+	++asyncLoader.requested;
+
+	auto cached = textures.find(key);
+	if (cached != textures.end() && cached->second != nullptr) {
+		++textureReferences[key];
+		++asyncLoader.completed;
+		if (onLoaded)
+			onLoaded(cached->second);
+		return;
+	}
+
+	auto pending = asyncLoader.inFlight.find(key);
+	if (pending != asyncLoader.inFlight.end()) {
+		pending->second->onTexture.push_back(onLoaded);
+		pending->second->keepSurface = pending->second->keepSurface || keepSurface;
+		return;
+	}
+
+	std::shared_ptr<AsyncLoad> load(new AsyncLoad(file, key, trans, false));
+	load->onTexture.push_back(onLoaded);
+	load->keepSurface = keepSurface;
+	asyncLoader.inFlight[key] = load;
+	queueAsyncLoad(load);
+}
+
+void ResourceManager::loadSoundAsync(std::string file, std::function<void(Mix_Chunk *)> onLoaded) {
+	++asyncLoader.requested;
+
+	auto cached = sounds.find(file);
+	if (cached != sounds.end() && cached->second != nullptr) {
+		++asyncLoader.completed;
+		if (onLoaded)
+			onLoaded(cached->second);
+		return;
+	}
+
+	std::string key = "sound#" + file;
+	auto pending = asyncLoader.inFlight.find(key);
+	if (pending != asyncLoader.inFlight.end()) {
+		pending->second->onSound.push_back(onLoaded);
+		return;
+	}
+
+	std::shared_ptr<AsyncLoad> load(new AsyncLoad(file, key, SDL_Color(), true));
+	load->onSound.push_back(onLoaded);
+	asyncLoader.inFlight[key] = load;
+	queueAsyncLoad(load);
+}
+
+void ResourceManager::queueAsyncLoad(const std::shared_ptr<AsyncLoad> & load) {
+	startAsyncWorkers();
+	{
+		std::lock_guard<std::mutex> lock(asyncLoader.mutex);
+		asyncLoader.requests.push_back(load);
+	}
+	asyncLoader.wake.notify_one();
+}
+
+void ResourceManager::startAsyncWorkers() {
+	if (!asyncLoader.workers.empty())
+		return;
+
+	// leave a core for the game loop
+	unsigned int cores = std::thread::hardware_concurrency();
+	unsigned int count = cores > 1 ? std::min(4u, cores - 1) : 1;
+	for (unsigned int i = 0; i < count; ++i)
+		asyncLoader.workers.push_back(std::thread(asyncWorker));
+}
+
+void ResourceManager::asyncWorker() {
+	for (;;) {
+		std::shared_ptr<AsyncLoad> load;
+		{
+			std::unique_lock<std::mutex> lock(asyncLoader.mutex);
+			asyncLoader.wake.wait(lock, [] { return asyncLoader.stopping || !asyncLoader.requests.empty(); });
+			if (asyncLoader.stopping)
+				return;
+			load = asyncLoader.requests.front();
+			asyncLoader.requests.pop_front();
+		}
+
+		try {
+			// a reload wants the edited loose file, not the cooked copy
+			if (load->isSound) {
+				load->chunk = decodeSound(load->fileName, !load->reload);
+			}
+			else {
+				// convert here, with the color key turned into alpha, so the render thread only uploads
+				SDL_Surface * surf = loadSurface(load->fileName, !load->reload);
+				SDL_SetColorKey(surf, SDL_TRUE, SDL_MapRGB(surf->format, load->transparent.r, load->transparent.g, load->transparent.b));
+				load->surface = SDL_ConvertSurfaceFormat(surf, SDL_PIXELFORMAT_ARGB8888, 0);
+				SDL_FreeSurface(surf);
+			}
+		}
+		catch (EngineException &) {
+			// thrown again by processAsyncLoads, exceptions must not leave a worker
+			load->error = std::current_exception();
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(asyncLoader.mutex);
+			asyncLoader.decoded.push_back(load);
+		}
+	}
+}
+
+void ResourceManager::processAsyncLoads(const Uint32 & budgetMs) {
+	Uint32 start = SDL_GetTicks();
+	if (hotReload.enabled)
+		pollFileChanges();
+
+	for (;;) {
+		std::shared_ptr<AsyncLoad> load;
+		{
+			std::lock_guard<std::mutex> lock(asyncLoader.mutex);
+			if (asyncLoader.decoded.empty())
+				return;
+			load = asyncLoader.decoded.front();
+			asyncLoader.decoded.pop_front();
+		}
+		if (!load->reload)
+			asyncLoader.inFlight.erase(load->key);
+
+		// a file that failed to load stops startup like load* does, a failed reload keeps what is loaded
+		if (load->error && !load->reload)
+			std::rethrow_exception(load->error);
+#ifdef __DEBUG
+		if (load->error)
+			debug("Reload failed, keeping the loaded version:", load->fileName.c_str());
+#endif
+
+		if (load->reload) {
+			applyReload(*load);
+		}
+		else if (load->isSound) {
+			Mix_Chunk * sound = load->chunk;
+			auto cached = sounds.find(load->fileName);
+			if (cached != sounds.end() && cached->second != nullptr) {
+				if (sound)
+					Mix_FreeChunk(sound);
+				sound = cached->second;
+			}
+			else if (sound) {
+				sounds[load->fileName] = sound;
+				watchFile(load->fileName);
+			}
+			asyncLoader.completed += (Uint32)load->onSound.size();
+			for (auto & onLoaded : load->onSound)
+				if (onLoaded)
+					onLoaded(sound);
+		}
+		else {
+			SDL_Texture * texture = nullptr;
+			int references = (int)load->onTexture.size();
+			auto cached = textures.find(load->key);
+			if (cached != textures.end() && cached->second != nullptr) {
+				texture = cached->second;
+				textureReferences[load->key] += references;
+			}
+			else if (load->surface) {
+				texture = GFX::createTextureFromSurface(load->surface);
+				if (texture) {
+					textures[load->key] = texture;
+					textureReferences[load->key] = references;
+					watchFile(load->fileName);
+					if (load->keepSurface) {
+						keptSurfaces[load->key] = load->surface;
+						load->surface = nullptr;
+					}
+				}
+				else {
+					SDL_FreeSurface(load->surface);
+					throw EngineException(SDL_GetError(), load->fileName);
+				}
+			}
+			if (load->surface)
+				SDL_FreeSurface(load->surface);
+			load->surface = nullptr;
+
+			asyncLoader.completed += (Uint32)references;
+			for (auto & onLoaded : load->onTexture)
+				if (onLoaded)
+					onLoaded(texture);
+		}
+
+		if (SDL_GetTicks() - start >= budgetMs)
+			return;
+	}
+}
+
+float ResourceManager::getAsyncLoadProgress() {
+	if (asyncLoader.requested == 0)
+		return 1.0f;
+	return (float)asyncLoader.completed / asyncLoader.requested;
+}
+
+bool ResourceManager::isAsyncLoadComplete() {
+	return asyncLoader.completed == asyncLoader.requested;
+}
+
+void ResourceManager::stopAsyncLoads() {
+	{
+		std::lock_guard<std::mutex> lock(asyncLoader.mutex);
+		asyncLoader.stopping = true;
+	}
+	asyncLoader.wake.notify_all();
+	for (std::thread & worker : asyncLoader.workers)
+		worker.join();
+	asyncLoader.workers.clear();
+
+	// anything not uploaded yet is dropped without calling back
+	for (auto & load : asyncLoader.decoded) {
+		if (load->surface)
+			SDL_FreeSurface(load->surface);
+		if (load->chunk)
+			Mix_FreeChunk(load->chunk);
+	}
+	asyncLoader.requests.clear();
+	asyncLoader.decoded.clear();
+	asyncLoader.inFlight.clear();
+	asyncLoader.requested = asyncLoader.completed = 0;
+	asyncLoader.stopping = false;
+}
+
+void ResourceManager::enableHotReload(const bool & enable) {
+	if (enable == hotReload.enabled)
+		return;
+
+	hotReload.enabled = enable;
+	if (!enable) {
+#ifdef __linux__
+		if (hotReload.notifyFd >= 0)
+			close(hotReload.notifyFd);
+#endif
+		hotReload.notifyFd = -1;
+		hotReload.directories.clear();
+		hotReload.files.clear();
+		return;
+	}
+
+#ifdef __linux__
+	hotReload.notifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#ifdef __DEBUG
+	if (hotReload.notifyFd < 0)
+		debug("inotify unavailable, polling modification times");
+#endif
+#endif
+
+	// resources loaded so far, later ones are watched as they load
+	for (auto & pair : textures)
+		if (pair.first.compare(0, 6, "atlas#") != 0)
+			watchFile(pair.first.substr(0, pair.first.rfind('#')));
+	for (auto & pair : sounds)
+		watchFile(pair.first);
+	for (auto & image : hotReload.atlasImages)
+		watchFile(image.fileName);
+}
+
+void ResourceManager::setTextureReloadCallback(std::function<void(SDL_Texture *, SDL_Texture *)> onReloaded) {
+	hotReload.onTextureReloaded = onReloaded;
+}
+
+void ResourceManager::watchFile(const std::string & file) {
+	if (!hotReload.enabled || hotReload.files.count(file))
+		return;
+
+	hotReload.files[file] = modificationTime(file);
+#ifdef __linux__
+	if (hotReload.notifyFd < 0)
+		return;
+
+	// editors often save to a new file and rename it over the old one, which a watch on the file itself would miss
+	size_t slash = file.rfind('/');
+	std::string directory = slash == std::string::npos ? "." : file.substr(0, slash);
+	int watch = inotify_add_watch(hotReload.notifyFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+	if (watch >= 0)
+		hotReload.directories[watch] = slash == std::string::npos ? "" : file.substr(0, slash + 1);
+#endif
+}
+
+void ResourceManager::pollFileChanges() {
+	std::vector<std::string> changed;
+	bool notified = false;
+
+#ifdef __linux__
+	if (hotReload.notifyFd >= 0) {
+		notified = true;
+		alignas(struct inotify_event) char buffer[4096];
+		ssize_t length;
+		while ((length = read(hotReload.notifyFd, buffer, sizeof(buffer))) > 0) {
+			for (char * next = buffer; next < buffer + length; ) {
+				const struct inotify_event * event = (const struct inotify_event *)next;
+				next += sizeof(struct inotify_event) + event->len;
+
+				auto directory = hotReload.directories.find(event->wd);
+				if (event->len == 0 || directory == hotReload.directories.end())
+					continue;
+				std::string file = directory->second + event->name;
+				if (hotReload.files.count(file) && std::find(changed.begin(), changed.end(), file) == changed.end())
+					changed.push_back(file);
+			}
+		}
+	}
+#endif
+
+	// without notifications, stat every watched file a couple of times a second
+	if (!notified && SDL_GetTicks() - hotReload.lastPoll >= 500) {
+		hotReload.lastPoll = SDL_GetTicks();
+		for (auto & pair : hotReload.files) {
+			time_t modified = modificationTime(pair.first);
+			if (modified == pair.second)
+				continue;
+			pair.second = modified;
+			if (modified != 0)
+				changed.push_back(pair.first);
+		}
+	}
+
+	for (const std::string & file : changed)
+		reloadFile(file);
+}
+
+void ResourceManager::reloadFile(const std::string & file) {
+	auto sound = sounds.find(file);
+	if (sound != sounds.end() && sound->second != nullptr) {
+		std::shared_ptr<AsyncLoad> load(new AsyncLoad(file, "sound#" + file, SDL_Color(), true));
+		load->reload = true;
+		queueAsyncLoad(load);
+	}
+
+	// one decode for each transparent color the image is used with
+	std::vector<SDL_Color> colors;
+	auto addColor = [&colors](const SDL_Color & color) {
+		for (const SDL_Color & other : colors)
+			if (other.r == color.r && other.g == color.g && other.b == color.b)
+				return;
+		colors.push_back(color);
+	};
+	std::string prefix = file + "#";
+	for (auto it = textures.lower_bound(prefix); it != textures.end() && it->first.compare(0, prefix.size(), prefix) == 0; ++it) {
+		Uint32 rgb = (Uint32)std::strtoul(it->first.c_str() + prefix.size(), nullptr, 16);
+		addColor(SDL_Color{ (Uint8)(rgb >> 16), (Uint8)(rgb >> 8), (Uint8)rgb, 255 });
+	}
+	for (const AtlasImage & image : hotReload.atlasImages)
+		if (image.fileName == file)
+			addColor(image.transparent);
+
+	for (const SDL_Color & color : colors) {
+		std::shared_ptr<AsyncLoad> load(new AsyncLoad(file, textureKey(file, color), color, false));
+		load->reload = true;
+		queueAsyncLoad(load);
+	}
+
+#ifdef __DEBUG
+	debug("File changed, reloading:", file.c_str());
+#endif
+}
+
+void ResourceManager::applyReload(AsyncLoad & load) {
+	if (load.isSound) {
+		auto cached = sounds.find(load.fileName);
+		if (nullptr == load.chunk || cached == sounds.end() || nullptr == cached->second) {
+			if (load.chunk)
+				Mix_FreeChunk(load.chunk);
+			return;
+		}
+
+		// the new samples move into the chunk everyone already holds, channels still reading the old ones are stopped first
+		Mix_Chunk * live = cached->second;
+		for (int channel = 0; channel < Mix_AllocateChannels(-1); ++channel)
+			if (Mix_Playing(channel) && Mix_GetChunk(channel) == live)
+				Mix_HaltChannel(channel);
+		std::swap(live->allocated, load.chunk->allocated);
+		std::swap(live->abuf, load.chunk->abuf);
+		std::swap(live->alen, load.chunk->alen);
+		Mix_FreeChunk(load.chunk);
+		load.chunk = nullptr;
+#ifdef __DEBUG
+		debug("Sound reloaded:", load.fileName.c_str());
+#endif
+		return;
+	}
+
+	SDL_Surface * surf = load.surface;
+	load.surface = nullptr;
+	if (nullptr == surf)
+		return;
+
+	auto cached = textures.find(load.key);
+	if (cached != textures.end() && cached->second != nullptr) {
+		SDL_Texture * texture = cached->second;
+		int w = 0, h = 0;
+		SDL_QueryTexture(texture, nullptr, nullptr, &w, &h);
+		if (w == surf->w && h == surf->h && updateTexture(texture, nullptr, surf)) {
+			if (hotReload.onTextureReloaded)
+				hotReload.onTextureReloaded(texture, texture);
+		}
+		else {
+			// a new size needs a new texture, it takes over the cache entry and its references
+			SDL_Texture * replacement = GFX::createTextureFromSurface(surf);
+			if (replacement) {
+				cached->second = replacement;
+				if (hotReload.onTextureReloaded)
+					hotReload.onTextureReloaded(texture, replacement);
+				SDL_DestroyTexture(texture);
+			}
+		}
+#ifdef __DEBUG
+		debug("Texture reloaded:", load.key.c_str());
+#endif
+	}
+
+	for (const AtlasImage & image : hotReload.atlasImages) {
+		if (image.fileName != load.fileName || image.transparent.r != load.transparent.r
+			|| image.transparent.g != load.transparent.g || image.transparent.b != load.transparent.b)
+			continue;
+
+		if (image.region.rect.w != surf->w || image.region.rect.h != surf->h) {
+#ifdef __DEBUG
+			debug("Image no longer fits its atlas region, rebuild the atlas to see it:", load.fileName.c_str());
+#endif
+			continue;
+		}
+		if (updateTexture(image.region.texture, &image.region.rect, surf) && hotReload.onTextureReloaded)
+			hotReload.onTextureReloaded(image.region.texture, image.region.texture);
+	}
+
+	SDL_FreeSurface(surf);
+}
+
 Mix_Music * ResourceManager::loadMP3(std::string file) {
 	Mix_Music * mp3 = Mix_LoadMUS(file.c_str());
 	if (nullptr == mp3)
@@ -48,6 +907,10 @@ Mix_Music * ResourceManager::loadMP3(std::string file) {
 }
 
 void ResourceManager::freeResources() {
+	stopAsyncLoads();
+	enableHotReload(false);
+	hotReload.atlasImages.clear();
+
 	for (auto pair : fonts) {
 		if (pair.second) {
 			TTF_CloseFont(pair.second);
@@ -58,6 +921,10 @@ void ResourceManager::freeResources() {
 		}
 	}
 
+	for (auto pair : keptSurfaces)
+		SDL_FreeSurface(pair.second);
+	keptSurfaces.clear();
+
 	for (auto pair : textures) {
 		if (pair.second) {
 			SDL_DestroyTexture(pair.second);
@@ -67,6 +934,8 @@ void ResourceManager::freeResources() {
 #endif
 		}
 	}
+	textures.clear();
+	textureReferences.clear();
 
 	for (auto pair : sounds) {
 		if (pair.second) {
@@ -88,13 +957,25 @@ void ResourceManager::freeResources() {
 		}
 	}
 
+	// cooked sounds play from the mapping, so it goes last
+	closeArchive();
+
 #ifdef __DEBUG
 	debug("ResourceManager::freeResources() finished");
 #endif
 }
 
 SDL_Texture * ResourceManager::getTexture(std::string fileName) {
-	return textures[fileName];
+	// without a transparent color, any cached variant of the file will do
+	auto it = textures.lower_bound(fileName + "#");
+	if (it != textures.end() && it->first.compare(0, fileName.size() + 1, fileName + "#") == 0)
+		return it->second;
+	return nullptr;
+}
+
+SDL_Texture * ResourceManager::getTexture(std::string fileName, SDL_Color transparent) {
+	auto it = textures.find(textureKey(fileName, transparent));
+	return it != textures.end() ? it->second : nullptr;
 }
 
 TTF_Font * ResourceManager::getFont(std::string fileName) {
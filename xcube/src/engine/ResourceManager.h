@@ -3,16 +3,64 @@
 
 #include <map>
 #include <vector>
+#include <functional>
+#include <memory>
 
 #include "GraphicsEngine.h"
 #include "AudioEngine.h"
+#include "AssetArchive.h"
+
+/**
+* Where an image ended up in a texture atlas page
+*/
+struct AtlasRegion {
+	SDL_Texture * texture;
+	SDL_Rect rect;
+};
+
+struct AsyncLoad;
 
 class ResourceManager {
 	private:
 		static std::map<std::string, SDL_Texture *> textures;
+		static std::map<std::string, int> textureReferences;
+		static std::map<std::string, SDL_Surface *> keptSurfaces;	// decoded images kept for loadTextureAtlas, by texture key
 		static std::map<std::string, Mix_Chunk *> sounds;
 		static std::map<std::string, Mix_Music *> mp3files;
 		static std::map<std::string, TTF_Font *> fonts;
+
+		/* memory-mapped archive, entries point into the mapping */
+		static const Uint8 * archiveData;
+		static size_t archiveSize;
+		static void * archiveFile;
+		static void * archiveMapping;
+		static std::map<std::string, const AssetEntry *> archiveEntries;
+		static void closeArchive();
+
+		/**
+		* @return image from the archive if it has one, otherwise decoded from file
+		*/
+		static SDL_Surface * loadSurface(const std::string & fileName, const bool & useArchive = true);
+		static Mix_Chunk * decodeSound(const std::string & fileName, const bool & useArchive = true);
+
+		/* async loading, worker threads only read and decode */
+		static void asyncWorker();
+		static void startAsyncWorkers();
+		static void queueAsyncLoad(const std::shared_ptr<AsyncLoad> & load);
+		static void stopAsyncLoads();
+
+		/* hot reload, changed files are decoded like async loads and swapped in by processAsyncLoads() */
+		static void watchFile(const std::string & fileName);
+		static void pollFileChanges();
+		static void reloadFile(const std::string & fileName);
+		static void applyReload(AsyncLoad & load);
+
+		/**
+		* @return cache key of a texture, the same image loaded with
+		*         a different transparent color is a different texture
+		*/
+		static std::string textureKey(const std::string & fileName, const SDL_Color & transparent);
+		static void freeKeptSurface(const std::string & key);
 	public:
 
 		/**
@@ -21,6 +69,16 @@ class ResourceManager {
 		*/
 		static void freeResources();
 
+		/**
+		* Maps an archive made by AssetCooker, images and sounds found in it
+		* are then loaded from its pre-decoded data instead of the loose files.
+		* The archive stays mapped until freeResources()
+		*
+		* @return false if the archive could not be opened, is invalid or corrupt,
+		*         or another archive is already loaded, loose files are used then
+		*/
+		static bool loadArchive(std::string fileName);
+
 		/**
 		* load* functions will load the resource into cache (map)
 		* for later use as well as return the resource directly
@@ -28,12 +86,79 @@ class ResourceManager {
 		* After load* functions, the loaded resource can also be retrieved
 		* by calling get* with appropriate filename
 		*/
-		static SDL_Texture * loadTexture(std::string fileName, SDL_Color transparent);
+		static SDL_Texture * loadTexture(std::string fileName, SDL_Color transparent, const bool & keepSurface = false);
+
+		/**
+		* Textures are shared, loadTexture returns the cached texture for a file
+		* and transparent color pair and counts one more reference to it.
+		* Release each reference when done, the texture is destroyed with the last one
+		*
+		* keepSurface keeps the decoded image in memory until loadTextureAtlas packs it
+		* or the texture is destroyed, so packing it later needs no second decode
+		*/
+		static void releaseTexture(SDL_Texture * texture);
+
+		/**
+		* Counts one more reference to a cached texture
+		*/
+		static void retainTexture(SDL_Texture * texture);
+
+		/**
+		* Packs images into as few pageSize x pageSize textures as they fit in,
+		* an image larger than a page gets a page of its own.
+		* Pages are cached like any other texture with no references,
+		* retain a page for each user of it.
+		* Images loaded with keepSurface are packed from the kept surface,
+		* which is freed here, the rest are decoded again
+		*
+		* @param images - file and transparent color of each image
+		* @return the page and rectangle of each image, in the same order
+		*/
+		static std::vector<AtlasRegion> loadTextureAtlas(const std::vector<std::pair<std::string, SDL_Color>> & images, const int & pageSize = 1024);
 		static TTF_Font * loadFont(std::string fileName, const int & pointSize);
 		static Mix_Chunk * loadSound(std::string fileName);
 		static Mix_Music * loadMP3(std::string fileName);
 
+		/**
+		* Background loading, files are read and decoded on worker threads so the game loop keeps running
+		*
+		* processAsyncLoads() must be called once per frame on the render thread,
+		* it uploads decoded images for about budgetMs (at least one per call)
+		* and then calls onLoaded with the result.
+		* A file that fails to load throws its EngineException from processAsyncLoads,
+		* the same one load* would have thrown, a failed hot reload keeps the loaded version.
+		* Results are cached and reference counted the same as load*,
+		* onLoaded is called straight away if the resource is already cached.
+		* keepSurface is the same as for loadTexture, the kept image is the one the worker decoded
+		*/
+		static void loadTextureAsync(std::string fileName, SDL_Color transparent, std::function<void(SDL_Texture *)> onLoaded = nullptr, const bool & keepSurface = false);
+		static void loadSoundAsync(std::string fileName, std::function<void(Mix_Chunk *)> onLoaded = nullptr);
+		static void processAsyncLoads(const Uint32 & budgetMs = 4);
+
+		/**
+		* @return fraction of async loads requested so far that have finished, 1 when nothing is pending
+		*/
+		static float getAsyncLoadProgress();
+		static bool isAsyncLoadComplete();
+
+		/**
+		* Watches the files behind loaded textures and sounds and reloads any that change,
+		* using inotify on Linux and file modification times elsewhere.
+		* A changed file is decoded on the loader threads and swapped in by processAsyncLoads(),
+		* new pixels and samples are copied into the existing texture and chunk so pointers stay valid.
+		* Only an image that changed size gets a new texture, images packed into an atlas keep their old pixels then
+		*/
+		static void enableHotReload(const bool & enable = true);
+
+		/**
+		* onReloaded is called on the render thread after a texture was reloaded,
+		* with the same texture twice if it was updated in place, otherwise with the old texture,
+		* destroyed right after the call, and the one replacing it
+		*/
+		static void setTextureReloadCallback(std::function<void(SDL_Texture *, SDL_Texture *)> onReloaded);
+
 		static SDL_Texture * getTexture(std::string fileName);
+		static SDL_Texture * getTexture(std::string fileName, SDL_Color transparent);
 		static TTF_Font * getFont(std::string fileName);
 		static Mix_Chunk * getSound(std::string fileName);
 		static Mix_Music * getMP3(std::string fileName);
@@ -1,6 +1,7 @@
 #include "XCube2d.h"
 
 std::shared_ptr<XCube2Engine> XCube2Engine::instance = nullptr;
+bool XCube2Engine::headless = false;
 
 XCube2Engine::XCube2Engine() {
 	std::cout << "Initializing X-CUBE 2D v" << _ENGINE_VERSION_MAJOR << "." << _ENGINE_VERSION_MINOR << std::endl;
@@ -15,7 +16,7 @@ XCube2Engine::XCube2Engine() {
 	#endif
 #endif
 
-	if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO) < 0)
+	if (SDL_Init(headless ? SDL_INIT_TIMER : SDL_INIT_VIDEO | SDL_INIT_AUDIO) < 0)
 		throw EngineException("SDL_Init()", SDL_GetError());
 
 #ifdef __DEBUG
@@ -42,19 +43,21 @@ XCube2Engine::XCube2Engine() {
 	debug("Inited srand() with", ticks);
 #endif
 
-	// init subsystems
+	// init subsystems, headless runs without graphics and audio
 
-	gfxInstance = std::shared_ptr<GraphicsEngine>(new GraphicsEngine());
+	if (!headless) {
+		gfxInstance = std::shared_ptr<GraphicsEngine>(new GraphicsEngine());
 
 #ifdef __DEBUG
-	debug("GraphicsEngine() successful");
+		debug("GraphicsEngine() successful");
 #endif
 
-	audioInstance = std::shared_ptr<AudioEngine>(new AudioEngine());
+		audioInstance = std::shared_ptr<AudioEngine>(new AudioEngine());
 
 #ifdef __DEBUG
-	debug("AudioEngine() successful");
+		debug("AudioEngine() successful");
 #endif
+	}
 
 	eventInstance = std::shared_ptr<EventEngine>(new EventEngine());
 
@@ -64,7 +67,12 @@ XCube2Engine::XCube2Engine() {
 
 	physicsInstance = std::shared_ptr<PhysicsEngine>(new PhysicsEngine());
 
+	jobInstance = std::shared_ptr<JobSystem>(new JobSystem(SDL_GetCPUCount() - 1));
+	std::cout << "Job workers: " << jobInstance->getWorkerCount() << std::endl;
+
     myEngineSystemInstance = std::shared_ptr<MyEngineSystem>(new MyEngineSystem());
+	myEngineSystemInstance->headless = headless;
+	myEngineSystemInstance->jobs = jobInstance;
 
 #ifdef __DEBUG
     debug("MyEngineSystem() successful");
@@ -81,11 +89,21 @@ XCube2Engine::~XCube2Engine() {
 	eventInstance.reset();
 	gfxInstance.reset();
 
+	// otherwise the graphics engine quits SDL
+	if (headless)
+		SDL_Quit();
+
 #ifdef __DEBUG
 	debug("XCube2Engine::~XCube2Engine() finished");
 #endif
 }
 
+void XCube2Engine::setHeadless(const bool & enable) {
+	if (instance)
+		throw EngineException("Headless mode must be chosen before the engine starts");
+	headless = enable;
+}
+
 void XCube2Engine::quit() {
 	if (instance)
 		instance.reset();
@@ -11,6 +11,8 @@
 #include "PhysicsEngine.h"
 #include "custom/MyEngineSystem.h"
 #include "ResourceManager.h"
+#include "Profiler.h"
+#include "JobSystem.h"
 #include "Timer.h"
 
 const int _ENGINE_VERSION_MAJOR = 0;
@@ -19,10 +21,12 @@ const int _ENGINE_VERSION_MINOR = 1;
 class XCube2Engine {
 	private:
 		static std::shared_ptr<XCube2Engine> instance;
+		static bool headless;
 		std::shared_ptr<GraphicsEngine> gfxInstance;
 		std::shared_ptr<AudioEngine> audioInstance;
 		std::shared_ptr<EventEngine> eventInstance;
 		std::shared_ptr<PhysicsEngine> physicsInstance;
+		std::shared_ptr<JobSystem> jobInstance;
 
         std::shared_ptr<MyEngineSystem> myEngineSystemInstance;
 
@@ -42,6 +46,16 @@ class XCube2Engine {
 		*/
 		static void quit();
 
+		/**
+		* Headless mode runs the game with no window, renderer or audio device,
+		* for simulating on machines without a display. Graphics and audio engines are nullptr,
+		* MyEngineSystem keeps sprite frame data without textures, plays no sounds
+		* and advances its clock by the simulated time instead of real time.
+		* Call before the first getInstance()
+		*/
+		static void setHeadless(const bool & headless);
+		static bool isHeadless() { return headless; }
+
 		/**
 		* Subsystems can only be accessed via the following accessors
 		* @return approriate subsystem of the engine
@@ -51,6 +65,12 @@ class XCube2Engine {
 		std::shared_ptr<EventEngine> getEventEngine() { return eventInstance; }
 		std::shared_ptr<PhysicsEngine> getPhysicsEngine() { return physicsInstance; }
         std::shared_ptr<MyEngineSystem> getMyEngineSystem() { return myEngineSystemInstance; }
+
+		/**
+		* Worker threads for the other cores, one fewer than SDL_GetCPUCount()
+		* since the main thread helps out while it waits on jobs
+		*/
+		std::shared_ptr<JobSystem> getJobSystem() { return jobInstance; }
 };
 
 typedef XCube2Engine XEngine;
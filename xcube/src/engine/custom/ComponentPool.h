@@ -0,0 +1,160 @@
+#ifndef __COMPONENT_POOL_H__
+#define __COMPONENT_POOL_H__
+#include "EntityHandle.h"																							// For entity slot indices
+#include <cstdint>																									// For std::uint32_t
+#include <cstddef>																									// For size_t
+#include <vector>																									// For dense and sparse storage
+#include <utility>																									// For std::move
+#include <tuple>																									// For view pool references
+
+using ComponentSignature = std::uint32_t;																			// One bit per component type
+
+/**
+* Sparse set component storage
+*
+* Components are packed into a contiguous array with a parallel array of owning entities,
+* the sparse array maps an entity's slot index to its packed slot so has/get are a single index,
+* and a handle only matches while its generation is the one stored in the pool.
+* Removal swaps the last component into the freed slot, so slots are not stable across erase.
+* A pool bound to a signature array keeps its bit in each entity's signature up to date
+*/
+template<typename T, typename Entity = std::uint32_t>
+class ComponentPool {
+public:
+	struct Entry { Entity first; T& second; };																		// Entity and component pair handed out by iteration
+	class iterator {																								// Iterates packed components in slot order
+	public:
+		iterator(ComponentPool* pool, size_t index) : pool(pool), index(index) {}									// Constructor
+		Entry operator*() const { return Entry{ pool->packedEntities[index], pool->packedComponents[index] }; }		// Current entry
+		iterator& operator++() { ++index; return *this; }															// Next slot
+		bool operator!=(const iterator& other) const { return index != other.index; }								// Compare slots
+	private:
+		ComponentPool* pool;																						// Owning pool
+		size_t index;																								// Current slot
+	};
+	bool has(Entity entity) const { return slot(entity) != NONE; }													// Does entity have this component
+	T* find(Entity entity) { std::uint32_t i = slot(entity); return i != NONE ? &packedComponents[i] : nullptr; }	// Component pointer or nullptr
+	T& operator[](Entity entity) { std::uint32_t i = slot(entity); return i != NONE ? packedComponents[i] : insert(entity, T()); }	// Get component, default construct if missing
+	T& insert(Entity entity, const T& component);																	// Add or replace component
+	void erase(Entity entity);																						// Remove component, swapping the last slot in
+	void clear();																									// Remove all components
+	void bindSignature(std::vector<ComponentSignature>* signatures, ComponentSignature bit) { this->signatures = signatures; signatureBit = bit; }	// Maintain bit in signatures[entity]
+	ComponentSignature bit() const { return signatureBit; }															// Signature bit of this pool
+	size_t size() const { return packedEntities.size(); }															// Number of components
+	bool empty() const { return packedEntities.empty(); }															// Is pool empty
+	const std::vector<Entity>& entities() const { return packedEntities; }											// Packed entity array
+	std::vector<T>& components() { return packedComponents; }														// Packed component array
+	iterator begin() { return iterator(this, 0); }																	// First slot
+	iterator end() { return iterator(this, packedEntities.size()); }												// Past last slot
+private:
+	static constexpr std::uint32_t NONE = { 0xFFFFFFFFu };															// Sparse value for missing component
+	std::uint32_t slot(Entity entity) const;																		// Packed slot of entity, NONE if missing or stale
+	std::vector<std::uint32_t> sparse;																				// Entity slot index to packed slot
+	std::vector<Entity> packedEntities;																				// Slot to entity
+	std::vector<T> packedComponents;																				// Slot to component
+	std::vector<ComponentSignature>* signatures = nullptr;															// Bound signature array, indexed by entity slot
+	ComponentSignature signatureBit = {};																			// Bit set in signatures of entities in this pool
+};
+
+template<typename T, typename Entity>
+constexpr std::uint32_t ComponentPool<T, Entity>::NONE;
+
+template<typename T, typename Entity>
+std::uint32_t ComponentPool<T, Entity>::slot(Entity entity) const
+{
+	std::uint32_t index = entityIndex(entity);																		// slot index of handle
+	if (index >= sparse.size() || sparse[index] == NONE) return NONE;												// IF NOT MAPPED, missing
+	return packedEntities[sparse[index]] == entity ? sparse[index] : NONE;											// IF GENERATION DIFFERS, stale handle
+}
+
+template<typename T, typename Entity>
+T& ComponentPool<T, Entity>::insert(Entity entity, const T& component)
+{
+	std::uint32_t index = entityIndex(entity);																		// slot index of handle
+	if (index < sparse.size() && sparse[index] != NONE) {															// IF SLOT INDEX ALREADY MAPPED
+		packedEntities[sparse[index]] = entity;																		// take over the slot, an older generation was never erased
+		return packedComponents[sparse[index]] = component;															// replace
+	}
+	if (index >= sparse.size()) sparse.resize(size_t(index) + 1, NONE);												// grow sparse array to cover entity
+	sparse[index] = std::uint32_t(packedEntities.size());															// map entity to new slot
+	packedEntities.push_back(entity);																				// append entity
+	packedComponents.push_back(component);																			// append component
+	if (signatures) {																								// IF BOUND TO SIGNATURES, set bit
+		if (index >= signatures->size()) signatures->resize(size_t(index) + 1, 0);									// grow signatures to cover entity
+		(*signatures)[index] |= signatureBit;																		// entity now has this component
+	}
+	return packedComponents.back();																					// return new component
+}
+
+template<typename T, typename Entity>
+void ComponentPool<T, Entity>::erase(Entity entity)
+{
+	std::uint32_t slot = this->slot(entity);																		// slot being freed
+	if (slot == NONE) return;																						// IF NOT PRESENT, return
+	std::uint32_t last = std::uint32_t(packedEntities.size() - 1);													// last slot
+	if (slot != last) {																								// IF NOT LAST, move last into freed slot
+		packedEntities[slot] = packedEntities[last];																// move entity
+		packedComponents[slot] = std::move(packedComponents[last]);													// move component
+		sparse[entityIndex(packedEntities[slot])] = slot;															// remap moved entity
+	}
+	packedEntities.pop_back();																						// drop last entity
+	packedComponents.pop_back();																					// drop last component
+	sparse[entityIndex(entity)] = NONE;																				// unmap erased entity
+	if (signatures) (*signatures)[entityIndex(entity)] &= ~signatureBit;											// IF BOUND TO SIGNATURES, clear bit
+}
+
+template<typename T, typename Entity>
+void ComponentPool<T, Entity>::clear()
+{
+	if (signatures) for (Entity entity : packedEntities) (*signatures)[entityIndex(entity)] &= ~signatureBit;		// IF BOUND TO SIGNATURES, clear bits
+	sparse.clear();																									// unmap all entities
+	packedEntities.clear();																							// drop entities
+	packedComponents.clear();																						// drop components
+}
+
+/**
+* Multi-component query over several pools
+*
+* each() walks the entity array of the smallest pool and looks every entity up once
+* in each pool, calling func(entity, components...) only when all are present.
+* func must not add or remove components in the queried pools, either can move packed
+* components out from under the references it was given or skip entities. Defer such
+* changes until each() returns, as destroyEntity does with its destroy queue
+*/
+template<typename Entity, typename... Ts>
+class ComponentView {
+public:
+	explicit ComponentView(ComponentPool<Ts, Entity>&... pools) : pools(pools...) {}								// Constructor
+	template<typename Func>
+	void each(Func func);																							// Call func(entity, Ts&...) for each entity with every component
+private:
+	std::tuple<ComponentPool<Ts, Entity>&...> pools;																// Queried pools
+	template<typename Func>
+	static void visit(Entity entity, Func& func, Ts*... components);												// Call func if every component was found
+};
+
+template<typename Entity, typename... Ts>
+template<typename Func>
+void ComponentView<Entity, Ts...>::each(Func func)
+{
+	const std::vector<Entity>* candidates[] = { &std::get<ComponentPool<Ts, Entity>&>(pools).entities()... };		// entity array of each pool
+	const std::vector<Entity>* smallest = candidates[0];															// smallest entity array
+	for (const std::vector<Entity>* candidate : candidates)															// FOR EACH POOL
+		if (candidate->size() < smallest->size()) smallest = candidate;												// IF SMALLER, iterate this one
+	for (size_t i = 0; i < smallest->size(); ++i) {																	// FOR EACH ENTITY
+		Entity entity = (*smallest)[i];																				// get entity
+		visit(entity, func, std::get<ComponentPool<Ts, Entity>&>(pools).find(entity)...);							// one lookup per pool
+	}
+}
+
+template<typename Entity, typename... Ts>
+template<typename Func>
+void ComponentView<Entity, Ts...>::visit(Entity entity, Func& func, Ts*... components)
+{
+	bool found = true;																								// all components found
+	using expand = int[];																							// pack expansion helper
+	(void)expand { 0, (found = found && components != nullptr, 0)... };												// check each component
+	if (found) func(entity, *components...);																		// IF ALL FOUND, call func
+}
+
+#endif
\ No newline at end of file
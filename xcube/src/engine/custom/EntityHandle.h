@@ -0,0 +1,20 @@
+#ifndef __ENTITY_HANDLE_H__
+#define __ENTITY_HANDLE_H__
+#include <cstdint>																									// For std::uint32_t
+
+/**
+* Entity handle layout
+*
+* The low bits hold the slot index used to address per-entity arrays, the bits above hold
+* the generation of that slot. Slots are recycled once an entity is destroyed and the
+* generation is bumped, so handles issued before the slot was freed no longer match.
+* The top bit is left clear so handles stay positive when stored as int
+*/
+static constexpr std::uint32_t ENTITY_INDEX_BITS = { 20 };															// Bits for the slot index, about a million live entities
+static constexpr std::uint32_t ENTITY_INDEX_MASK = { (1u << ENTITY_INDEX_BITS) - 1 };								// Slot index mask
+static constexpr std::uint32_t ENTITY_GENERATION_MASK = { 0x7FFu };													// Generation mask after shifting, 11 bits
+inline std::uint32_t entityIndex(std::uint32_t entity) { return entity & ENTITY_INDEX_MASK; }						// Slot index of handle
+inline std::uint32_t entityGeneration(std::uint32_t entity) { return (entity >> ENTITY_INDEX_BITS) & ENTITY_GENERATION_MASK; }	// Generation of handle
+inline std::uint32_t makeEntity(std::uint32_t index, std::uint32_t generation) { return ((generation & ENTITY_GENERATION_MASK) << ENTITY_INDEX_BITS) | index; }	// Build handle
+
+#endif
@@ -4,15 +4,19 @@ MyEngineSystem::MyEngineSystem() {																			// Constructor
 #ifdef __DEBUG																								// Debug info
 	debug("MyEngineSystem constructed");																	// Log construction
 #endif																										// Debug info
+	buildCollisionResponses();																				// fill collision response table
+	ResourceManager::setTextureReloadCallback([this](SDL_Texture* oldTexture, SDL_Texture* newTexture) { onTextureReloaded(oldTexture, newTexture); });	// follow hot reloaded textures
 }
 
 MyEngineSystem::~MyEngineSystem() {																			// Destructor
 #ifdef __DEBUG																								// Debug info
 	debug("MyEngineSystem::~MyEngineSystem() freeing resources");											// Log destruction
 #endif																										// Debug info
+	ResourceManager::setTextureReloadCallback(nullptr);														// stop following hot reloaded textures
 	loadedSprites.clear();																					// Clear sprites
 	loadedSounds.clear();																					// Clear sounds
 	groundTiles.clear();																					// Clear ground tiles
+	if (SDL_WasInit(SDL_INIT_VIDEO)) releaseTileChunks();													// IF RENDERER STILL UP, destroy chunk render targets
 	projectilePools.clear();																				// Clear projectile pools
 	entitiesToDestroy.clear(); 																				// Clear entities to destroy
 	activeEntities.clear();																					// Clear active entities
@@ -20,198 +24,328 @@ MyEngineSystem::~MyEngineSystem() {																			// Destructor
 
 void MyEngineSystem::update(float deltaTime, int playerEntityId)
 {
-	now = SDL_GetTicks();																					// get current time
-	aiSystem(component, playerEntityId, deltaTime);															// update AI
-	movementSystem(component, deltaTime);																	// update movement
-	collisionSystem(component, deltaTime);																	// update collisions
-	updateAnimationStates(component, deltaTime);															// update animation states
-	animationSystem(component, deltaTime);																	// update animations
+	simulatedTime += deltaTime;																				// advance simulated clock
+	now = headless ? Uint32(simulatedTime * 1000.0) : SDL_GetTicks();										// get current time, simulated when headless
+	for (Transform& transform : component.transforms.components()) transform.previousPosition = transform.position;	// remember where this step starts, for interpolated rendering
+	if (jobs) {																								// IF JOB SYSTEM, run the system graph on the workers
+		JobHandle ai = jobs->schedule([&] { aiSystem(component, Entity(playerEntityId), deltaTime); });		// AI reads transforms, writes NPC inputs
+		JobHandle animation = jobs->schedule([&] { animationSystem(component, deltaTime); });				// animations only, runs alongside AI and movement
+		JobHandle movement = jobs->schedule([&] { movementSystem(component, deltaTime); }, { ai });			// movement needs this step's inputs
+		JobHandle collision = jobs->schedule([&] { collisionSystem(component, deltaTime); }, { movement, animation });	// collision touches everything, starts dying animations
+		JobHandle states = jobs->schedule([&] { updateAnimationStates(component, deltaTime); }, { collision });	// animation states follow resolved velocities
+		jobs->wait(states);																					// help out until the graph is done
+	}
+	else {																									// ELSE same graph in order on this thread
+		aiSystem(component, Entity(playerEntityId), deltaTime);												// update AI
+		animationSystem(component, deltaTime);																// update animations
+		movementSystem(component, deltaTime);																// update movement
+		collisionSystem(component, deltaTime);																// update collisions
+		updateAnimationStates(component, deltaTime);														// update animation states
+	}
 	processPendingDeaths();																					// handle deaths whose animation finished
 	flushDestroyedEntities();																				// flush destroyed entities
+	PROFILE_COUNTER("entities", getEntityCount());															// live entities for traces
+	PROFILE_COUNTER("collisionPairsTested", collisionPairsTested);											// candidate pairs tested this step
+	if (levelClearPending) {																				// IF LEVEL END WAS REACHED THIS FRAME
+		levelClearPending = false;																			// reset pending flag
+		clearLevelExcept(levelClearKeeper);																	// clear level except player
+	}
 }
 
 void MyEngineSystem::aiSystem(Component& com, Entity playerEntity, float deltaTime)
 {
+	PROFILE_ZONE("aiSystem");
 	if (playerEntity == 0) return;																			// IF NO PLAYER ENTITY, return
 	if (!isValidComponent(playerEntity, com.transforms)) return;											// IF NO PLAYER TRANSFORM, return
-	const Transform& pcTransform = com.transforms[playerEntity];											// get player transform
-	for (auto& npc : com.npcs) {																			// FOR EACH NPC
-		Entity entity = npc.first;																			// get entity
-		if (!isValidComponent(entity, com.transforms)) continue;											// IF NO NPC TRANSFORM, skip
-		Transform& npcTransform = com.transforms[entity];													// get transform
-		float dx = pcTransform.position.x - npcTransform.position.x;										// delta x
-		float dy = pcTransform.position.y - npcTransform.position.y;										// delta y
-		float distance = dx * dx + dy * dy;																	// distance squared
-		if (distance <= DEFAULT_NPC_CHASE_RANGE && distance > 0.0f) {										// IF WITHIN CHASE RANGE AND DISTANCE > 0 to avoid division by zero
-			float distSqrt = std::sqrt(distance);															// distance
-			float newVelX = dx / distSqrt;																	// normalised x
-			float newVelY = dy / distSqrt;																	// normalised y
-			com.inputs[entity] = Input{ newVelX, newVelY };													// set input to move towards player
+	const Vector2f pcPosition = com.transforms[playerEntity].position;										// copy player position, read by every chunk
+	for (Entity entity : com.npcs.entities())																// FOR EACH NPC, make sure it has an input to write,
+		if (com.transforms.has(entity) && !com.inputs.has(entity)) com.inputs.insert(entity, Input{});		// pools must not grow while chunks run
+	const std::vector<Entity>& npcs = com.npcs.entities();													// NPCs, split into chunks
+	parallelFor(npcs.size(), [&](size_t begin, size_t end) {												// FOR EACH CHUNK OF NPCS, on the job workers
+		for (size_t i = begin; i < end; ++i) {																// FOR EACH NPC IN CHUNK
+			const Transform* npcTransform = com.transforms.find(npcs[i]);									// find NPC transform
+			if (!npcTransform) continue;																	// IF NO TRANSFORM, skip
+			float dx = pcPosition.x - npcTransform->position.x;												// delta x
+			float dy = pcPosition.y - npcTransform->position.y;												// delta y
+			float distance = dx * dx + dy * dy;																// distance squared
+			Input& input = *com.inputs.find(npcs[i]);														// NPC input, added above
+			if (distance <= DEFAULT_NPC_CHASE_RANGE && distance > 0.0f) {									// IF WITHIN CHASE RANGE AND DISTANCE > 0 to avoid division by zero
+				float distSqrt = std::sqrt(distance);														// distance
+				input = Input{ dx / distSqrt, dy / distSqrt };												// set normalised input to move towards player
+			}
+			else input = Input{};																			// ELSE stop movement
 		}
-		else com.inputs[entity] = Input{};																	// ELSE stop movement
-	}
+	});
 }
 
 void MyEngineSystem::movementSystem(Component& com, float deltaTime)
 {
-	for (auto& inputComp : com.inputs) {																	// FOR EACH INPUT
-		Entity entity = inputComp.first;																	// get entity
-		const Input& input = inputComp.second;																// get input
-		float dx = input.x;																					// get input x
-		float dy = input.y;																					// get input y
-		float length = std::sqrt(dx * dx + dy * dy);														// calculate length
-		if (length > 1.0f) { dx /= length; dy /= length; }													// normalise if length > 1
-		float speed = DEFAULT_UNIT_SPEED;																	// default speed
-		if (isValidComponent(entity, com.speeds)) speed = com.speeds[entity].value;							// IF HAS SPEED COMPONENT, get speed
-		com.velocities[entity] = Velocity{ dx * speed, dy * speed };										// set velocity
-	}
-	for (auto& velocityComp : com.velocities) {																// FOR EACH VELOCITY
-		Entity entity = velocityComp.first;																	// get entity
-		if (!isValidComponent(entity, com.transforms)) continue;											// IF NO TRANSFORM, skip
-		Transform& transform = com.transforms[entity];														// get transform
-		if (!transform.active) continue;																	// IF NOT ACTIVE, skip
-		const Velocity& velocity = velocityComp.second;														// get velocity
-		float attemptedX = transform.position.x + velocity.x * deltaTime;									// calculate attempted X
-		float attemptedY = transform.position.y + velocity.y * deltaTime;									// calculate attempted Y
-		transform.newPosition = Vector2f(attemptedX, attemptedY);											// set new position
-	}
+	PROFILE_ZONE("movementSystem");
+	for (Entity entity : com.inputs.entities())																// FOR EACH INPUT, make sure it has a velocity to write,
+		if (!com.velocities.has(entity)) com.velocities.insert(entity, Velocity{});							// pools must not grow while chunks run
+	const std::vector<Entity>& steered = com.inputs.entities();												// entities with input
+	parallelFor(steered.size(), [&](size_t begin, size_t end) {												// FOR EACH CHUNK OF INPUTS
+		for (size_t i = begin; i < end; ++i) {																// FOR EACH INPUT IN CHUNK
+			const Input& input = com.inputs.components()[i];												// get input
+			float dx = input.x;																				// get input x
+			float dy = input.y;																				// get input y
+			float length = std::sqrt(dx * dx + dy * dy);													// calculate length
+			if (length > 1.0f) { dx /= length; dy /= length; }												// normalise if length > 1
+			float speed = DEFAULT_UNIT_SPEED;																// default speed
+			if (const Speed* speedComp = com.speeds.find(steered[i])) speed = speedComp->value;				// IF HAS SPEED COMPONENT, get speed
+			*com.velocities.find(steered[i]) = Velocity{ dx * speed, dy * speed };							// set velocity
+		}
+	});
+	const std::vector<Entity>& movers = com.velocities.entities();											// entities with velocity
+	parallelFor(movers.size(), [&](size_t begin, size_t end) {												// FOR EACH CHUNK OF VELOCITIES
+		for (size_t i = begin; i < end; ++i) {																// FOR EACH VELOCITY IN CHUNK
+			Transform* transform = com.transforms.find(movers[i]);											// find transform
+			if (!transform || !transform->active) continue;													// IF NO TRANSFORM OR NOT ACTIVE, skip
+			const Velocity& velocity = com.velocities.components()[i];										// get velocity
+			transform->newPosition = Vector2f(transform->position.x + velocity.x * deltaTime, transform->position.y + velocity.y * deltaTime);	// set attempted position
+		}
+	});
 }
 
 void MyEngineSystem::collisionSystem(Component& com, float deltaTime)
 {
-	for (auto& velocityComp : com.velocities) {																					// FOR EACH VELOCITY
-		Entity entity = velocityComp.first;																						// get entity
-		Velocity velocity = velocityComp.second;																				// get velocity
-		if (!isValidComponent(entity, com.transforms))continue;																	// IF NO TRANSFORM, skip
-		if (!isValidComponent(entity, com.colliders)) continue;																	// IF NO COLLIDER, skip
-		Transform& transform = com.transforms[entity];																			// get transform
-		if (!transform.active) continue;																						// IF NOT ACTIVE, skip
-		Collider& collider = com.colliders[entity];																				// get collider
-		std::vector<std::pair<Entity, SDL_Rect>> obstacles;																		// vector of obstacles
-		obstacles.reserve(com.colliders.size());																				// reserve space
-		for (auto& colliderComp : com.colliders) {																				// FOR EACH OTHER COLLIDER
-			Entity other = colliderComp.first;																					// get other entity
-			if (other == entity) continue;																						// IF SAME ENTITY, skip
-			if (isProjectileOwner(entity, other)) continue;																		// IF PROJECTILE OWNER, skip
-			if (!isValidComponent(other, com.transforms)) continue;																// IF NO TRANSFORM, skip
-			const Transform& otherTransform = com.transforms[other];															// get other transform
-			if (!otherTransform.active) continue;																				// IF NOT ACTIVE, skip
-			obstacles.emplace_back(other, colliderComp.second.rect);															// add to obstacles
+	PROFILE_ZONE("collisionSystem");
+	collisionPairsTested = 0;																						// new frame, no pairs tested yet
+	collisionMovers.clear();																						// clear movers, keeps capacity
+	com.view<Velocity, Transform, Collider>().each([&](Entity entity, Velocity&, Transform& transform, Collider&) {	// FOR EACH MOVING COLLIDER
+		if (transform.active) collisionMovers.push_back(entity);													// IF ACTIVE, add to movers
+	});
+	collisionResults.resize(collisionMovers.size());																// one result per mover
+	collisionChunks.resize((collisionMovers.size() + JOB_CHUNK_SIZE - 1) / JOB_CHUNK_SIZE);							// one contact buffer per chunk of movers
+	for (CollisionChunk& chunk : collisionChunks) chunk.contacts.clear();											// clear contacts, keeps capacity
+	parallelFor(collisionMovers.size(), [&](size_t begin, size_t end) {												// FOR EACH CHUNK OF MOVERS, on the job workers
+		narrowPhase(com, begin, end, collisionChunks[begin / JOB_CHUNK_SIZE]);										// chunks start on multiples of JOB_CHUNK_SIZE
+	});
+	for (size_t i = 0; i < collisionMovers.size(); ++i) {															// FOR EACH MOVER, write back where the narrow phase left it
+		const Entity entity = collisionMovers[i];																	// get mover
+		CollisionResult result = collisionResults[i];																// copy its result
+		Transform& transform = *com.transforms.find(entity);														// get transform
+		Collider& collider = *com.colliders.find(entity);															// get collider, still at the start of the step
+		if (overlapsMover(entity, result.rect) && !overlapsMover(entity, collider.rect))							// IF IT MOVED ONTO A MOVER PLACED EARLIER AND STAYING PUT AVOIDS THAT,
+			result = CollisionResult{ transform.position, Velocity{}, collider.rect, result.pairsTested };			// stay put, the earlier mover took the space
+		transform.position = result.position;																		// update position
+		transform.newPosition = result.position;																	// keep newPosition in sync
+		*com.velocities.find(entity) = result.velocity;																// update velocity to reflect any changes
+		collider.rect = result.rect;																				// update collider position
+		broadphase.update(entity, collider.rect);																	// move collider in broadphase grid
+		collisionPairsTested += result.pairsTested;																	// pairs the narrow phase tested
+	}
+	collectContactPairs();																							// pairs the responses below resolve once each
+	for (const CollisionChunk& chunk : collisionChunks) applyCollisionContacts(chunk.contacts);						// responses in mover order, the same for any number of workers
+}
+
+void MyEngineSystem::narrowPhase(Component& com, size_t begin, size_t end, CollisionChunk& chunk)
+{
+	PROFILE_ZONE("narrowPhase");
+	for (size_t i = begin; i < end; ++i) {																		// FOR EACH MOVER IN CHUNK
+		const Entity entity = collisionMovers[i];																// get mover
+		const Transform& transform = *com.transforms.find(entity);												// get transform
+		Vector2f position = transform.newPosition;																// attempted position, adjusted below
+		Velocity velocity = *com.velocities.find(entity);														// copy velocity
+		SDL_Rect rect = com.colliders.find(entity)->rect;														// copy collider rect
+		SDL_Rect moved = { roundToInt(position.x), roundToInt(position.y), rect.w, rect.h };					// collider rect at attempted position
+		SDL_Rect swept = {};																					// area covered by this move
+		SDL_UnionRect(&rect, &moved, &swept);																	// union of current and attempted rects
+		broadphase.query(swept, chunk.candidates);																// get colliders in overlapping cells
+		chunk.obstacles.clear();																				// clear obstacles, keeps capacity
+		for (Entity other : chunk.candidates) {																	// FOR EACH NEARBY COLLIDER
+			if (other == entity) continue;																		// IF SAME ENTITY, skip
+			if (isProjectileOwner(entity, other)) continue;														// IF PROJECTILE OWNER, skip
+			const Transform* otherTransform = com.transforms.find(other);										// find other transform
+			if (!otherTransform || !otherTransform->active) continue;											// IF NO TRANSFORM OR NOT ACTIVE, skip
+			const Collider* otherCollider = com.colliders.find(other);											// find other collider
+			if (!otherCollider) continue;																		// IF NO COLLIDER, skip
+			chunk.obstacles.emplace_back(other, otherCollider->rect);											// add to obstacles, as it was at the start of the step
+		}
+		const bool projectile = hasAnyOf(entity, PROJECTILE_BIT);												// projectiles stop at walls instead of being blocked
+		bool hitWall = false;																					// projectile hit a wall, nothing after that counts
+		SDL_Rect rectX = rect;																					// copy collider rect
+		rectX.x = roundToInt(position.x);																		// update x position
+		for (const auto& obstacle : chunk.obstacles) {															// FOR EACH OBSTACLE
+			const Entity other = obstacle.first;																// get other entity
+			const SDL_Rect& obstacleRect = obstacle.second;														// get obstacle rect
+			if (SDL_HasIntersection(&rectX, &obstacleRect) == SDL_TRUE) {										// IF INTERSECTING
+				chunk.contacts.push_back(CollisionContact{ entity, other });									// record contact, responded to after every chunk is done
+				if ((signatureOf(entity) | signatureOf(other)) & (PROJECTILE_BIT | END_LEVEL_BIT)) continue;	// IF PROJECTILE OR END LEVEL, skip position adjustment
+				if (velocity.x > 0.0f) position.x = float(obstacleRect.x - rectX.w);							// IF MOVING RIGHT, adjust position
+				else position.x = float(obstacleRect.x + obstacleRect.w);										// ELSE ADJUST LEFT
+				velocity.x = 0.0f;																				// stop horizontal movement
+				rect.x = roundToInt(position.x);																// update collider position
+				break;																							// exit loop
+			}
+		}
+		rectX.x = roundToInt(position.x);																		// x position after entity collisions
+		int wallColumn = staticTiles.firstSolidColumn(rectX, velocity.x > 0.0f);								// nearest wall column in direction of travel
+		if (wallColumn >= 0) {																					// IF HIT A WALL
+			if (projectile) {																					// IF PROJECTILE, deactivated by the response pass
+				chunk.contacts.push_back(CollisionContact{ entity, 0 });										// record wall contact
+				hitWall = true;																					// skip the vertical pass
+			}
+			else {																								// ELSE block movement
+				if (velocity.x > 0.0f) position.x = float(wallColumn * int(TILE_SIZE) - rectX.w);				// IF MOVING RIGHT, adjust position
+				else position.x = float((wallColumn + 1) * int(TILE_SIZE));										// ELSE ADJUST LEFT
+				velocity.x = 0.0f;																				// stop horizontal movement
+				rect.x = roundToInt(position.x);																// update collider position
+			}
 		}
-		SDL_Rect rectX = collider.rect;																							// copy collider rect
-		rectX.x = roundToInt(transform.newPosition.x);																			// update x position
-		for (const auto& obstacle : obstacles) {																				// FOR EACH OBSTACLE
-			const Entity other = obstacle.first;																				// get other entity
-			const SDL_Rect& obstacleRect = obstacle.second;																		// get obstacle rect
-			if (SDL_HasIntersection(&rectX, &obstacleRect) == SDL_TRUE) {														// IF INTERSECTING
-				processCollisionEntities(com, entity, other, now);																// process collision
-				if (getEntityTag(entity) == EntityTag::PROJECTILE || getEntityTag(other) == EntityTag::PROJECTILE) continue;	// IF PROJECTILE, skip position adjustment
-				if (getEntityTag(entity) == EntityTag::ENDLEVEL || getEntityTag(other) == EntityTag::ENDLEVEL) continue;		// IF END LEVEL, skip position adjustment
-				if (velocity.x > 0.0f) transform.newPosition.x = float(obstacleRect.x - rectX.w);								// IF MOVING RIGHT, adjust position
-				else transform.newPosition.x = float(obstacleRect.x + obstacleRect.w);											// ELSE ADJUST LEFT
-				velocity.x = 0.0f;																								// stop horizontal movement
-				collider.rect.x = roundToInt(transform.newPosition.x);															// update collider position
-				break;																											// exit loop
+		SDL_Rect rectY = rect;																					// copy collider rect
+		rectY.x = roundToInt(position.x);																		// x position after horizontal pass
+		rectY.y = roundToInt(position.y);																		// update y position
+		for (const auto& obstacle : chunk.obstacles) {															// FOR EACH OBSTACLE
+			if (hitWall) break;																					// IF ALREADY HIT A WALL, stop
+			const Entity other = obstacle.first;																// get other entity
+			const SDL_Rect& obstacleRect = obstacle.second;														// get obstacle rect
+			if (SDL_HasIntersection(&rectY, &obstacleRect) == SDL_TRUE) {										// IF INTERSECTING
+				chunk.contacts.push_back(CollisionContact{ entity, other });									// record contact
+				if ((signatureOf(entity) | signatureOf(other)) & (PROJECTILE_BIT | END_LEVEL_BIT)) continue;	// IF PROJECTILE OR END LEVEL, skip position adjustment
+				if (velocity.y > 0.0f) position.y = float(obstacleRect.y - rectY.h);							// IF MOVING DOWN, adjust position
+				else position.y = float(obstacleRect.y + obstacleRect.h);										// ELSE ADJUST UP
+				velocity.y = 0.0f;																				// stop vertical movement
+				break;																							// exit loop
 			}
 		}
-		transform.position.x = transform.newPosition.x;																			// update position x
-		SDL_Rect rectY = collider.rect;																							// copy collider rect
-		rectY.y = roundToInt(transform.newPosition.y);																			// update y position
-		for (const auto& obstacle : obstacles) {																				// FOR EACH OBSTACLE
-			const Entity other = obstacle.first;																				// get other entity
-			const SDL_Rect& obstacleRect = obstacle.second;																		// get obstacle rect
-			if (SDL_HasIntersection(&rectY, &obstacleRect) == SDL_TRUE) {														// IF INTERSECTING
-				processCollisionEntities(com, entity, other, now);																// process collision
-				if (getEntityTag(entity) == EntityTag::PROJECTILE || getEntityTag(other) == EntityTag::PROJECTILE) continue;	// IF PROJECTILE, skip position adjustment
-				if (getEntityTag(entity) == EntityTag::ENDLEVEL || getEntityTag(other) == EntityTag::ENDLEVEL) continue;		// IF END LEVEL, skip position adjustment
-				if (velocity.y > 0.0f) transform.newPosition.y = float(obstacleRect.y - rectY.h);								// IF MOVING DOWN, adjust position
-				else transform.newPosition.y = float(obstacleRect.y + obstacleRect.h);											// ELSE ADJUST UP
-				velocity.y = 0.0f;																								// stop vertical movement
-				collider.rect.y = roundToInt(transform.newPosition.y);															// update collider position
-				break;																											// exit loop
+		rectY.y = roundToInt(position.y);																		// y position after entity collisions
+		int wallRow = hitWall ? -1 : staticTiles.firstSolidRow(rectY, velocity.y > 0.0f);						// nearest wall row in direction of travel
+		if (wallRow >= 0) {																						// IF HIT A WALL
+			if (projectile) chunk.contacts.push_back(CollisionContact{ entity, 0 });							// IF PROJECTILE, record wall contact
+			else {																								// ELSE block movement
+				if (velocity.y > 0.0f) position.y = float(wallRow * int(TILE_SIZE) - rectY.h);					// IF MOVING DOWN, adjust position
+				else position.y = float((wallRow + 1) * int(TILE_SIZE));										// ELSE ADJUST UP
+				velocity.y = 0.0f;																				// stop vertical movement
 			}
 		}
-		transform.position.y = transform.newPosition.y;																			// update position y
-		collider.rect.x = roundToInt(transform.position.x);																		// update collider position x
-		collider.rect.y = roundToInt(transform.position.y);																		// update collider position y
-		com.velocities[entity] = velocity;																						// update velocity to reflect any changes
+		rect.x = roundToInt(position.x);																		// collider position x
+		rect.y = roundToInt(position.y);																		// collider position y
+		collisionResults[i] = CollisionResult{ position, velocity, rect, Uint32(chunk.obstacles.size()) };		// store result, written back serially
 	}
 }
 
-void MyEngineSystem::processCollisionEntities(Component& com, Entity primary, Entity other, Uint32 now)
+bool MyEngineSystem::overlapsMover(Entity entity, const SDL_Rect& rect)
 {
-	if ((getEntityTag(primary) == EntityTag::ENDLEVEL && getEntityTag(other) == EntityTag::PC)											// IF PRIMARY IS ENDLEVEL AND OTHER IS PC
-		|| (getEntityTag(other) == EntityTag::ENDLEVEL && getEntityTag(primary) == EntityTag::PC)) {									// OR VICE VERSA
-		Entity player = (getEntityTag(primary) == EntityTag::PC) ? primary : other;														// get player entity
-		Entity endTrigger = (getEntityTag(primary) == EntityTag::ENDLEVEL) ? primary : other;											// get end level trigger entity
-		if (currentLevel + 1 >= levelsCount) {																							// IF LAST LEVEL 
-			if (getNPCCount() <= 0) {																									// IF NO NPCS LEFT
-				gameCompleted = true;																									// set game completed
-				return;																													// return
-			}
-			else return;																												// return
-		}
-		++currentLevel;																													// increment level									
-		levelChanging = true;																											// set level changing
-		if (isValidComponent(endTrigger, com.audios) && !com.audios[endTrigger].attackingSound.empty())									// IF END TRIGGER HAS AUDIO COMPONENT AND ATTACKING SOUND
-			playAudio(com.audios[endTrigger].attackingSound, DEFAULT_SFX_VOLUME);														// play sound
-		clearLevelExcept(player);																										// clear level except player
-		return;																															// return
+	if (hasAnyOf(entity, PROJECTILE_BIT | END_LEVEL_BIT)) return false;										// IF NEVER BLOCKED, return
+	broadphase.query(rect, separationCandidates);															// get colliders in overlapping cells
+	for (Entity other : separationCandidates) {																// FOR EACH NEARBY COLLIDER
+		if (other == entity) continue;																		// IF SAME ENTITY, skip
+		const Signature signature = signatureOf(other);														// other components
+		if (!(signature & VELOCITY_BIT) || (signature & (PROJECTILE_BIT | END_LEVEL_BIT))) continue;		// IF NOT A MOVER OR NEVER BLOCKS, skip
+		const Transform* otherTransform = component.transforms.find(other);									// find other transform
+		if (!otherTransform || !otherTransform->active) continue;											// IF NO TRANSFORM OR NOT ACTIVE, skip
+		const Collider* otherCollider = component.colliders.find(other);									// find other collider
+		if (otherCollider && SDL_HasIntersection(&rect, &otherCollider->rect) == SDL_TRUE) return true;		// IF INTERSECTING, return true
 	}
-	Entity attacker = 0, victim = 0;																									// attacker and victim
-	if (getEntityTag(primary) == EntityTag::AMMO) { increaseAmmo(primary, other); return; }												// IF PRIMARY IS AMMO, increase ammo and return
-	else if (getEntityTag(other) == EntityTag::AMMO) { increaseAmmo(other, primary); return; }											// IF OTHER IS AMMO, increase ammo and return
-	else if (getEntityTag(primary) == EntityTag::HEALTH && getEntityTag(other) == EntityTag::NPC										// IF ATTACKER IS HEALTH AND VICTIM IS NPC
-		|| getEntityTag(primary) == EntityTag::NPC && getEntityTag(other) == EntityTag::HEALTH) return;									// OR VICE VERSA, return
-	else if (getEntityTag(primary) == EntityTag::HEALTH) {																				// IF ATTACKER IS HEALTH PICKUP
-		Health& health = com.healths[other];																							// get health of victim	
-		if (health.currentHealth >= health.maxHealth) return;																			// IF HEALTH IS MAX, return
-		attacker = primary; victim = other;																								// set attacker and victim
-	}
-	else if (getEntityTag(other) == EntityTag::HEALTH) {																				// IF VICTIM IS HEALTH PICKUP
-		Health& health = com.healths[primary];																							// get health of attacker
-		if (health.currentHealth >= health.maxHealth) return;																			// IF HEALTH IS MAX, return
-		attacker = other; victim = primary;																								// set attacker and victim
-	}
-	else if (getEntityTag(primary) == EntityTag::PROJECTILE) { attacker = primary; victim = other; }									// IF PRIMARY IS PROJECTILE, set attacker and victim
-	else if (getEntityTag(other) == EntityTag::PROJECTILE) { attacker = other; victim = primary; }										// IF OTHER IS PROJECTILE, set attacker and victim
-	else if (getEntityTag(primary) == EntityTag::NPC && getEntityTag(other) == EntityTag::PC) { attacker = primary; victim = other; }	// IF PRIMARY IS NPC AND OTHER IS PC, set attacker and victim
-	else if (getEntityTag(other) == EntityTag::NPC && getEntityTag(primary) == EntityTag::PC) { attacker = other; victim = primary; }	// IF OTHER IS NPC AND PRIMARY IS PC, set attacker and victim
-	if (attacker <= 0 && victim < 0) return;																							// IF NO ATTACKER OR VICTIM, return
-	std::string audioString = {};																										// audio string
-	if (!isValidComponent(attacker, com.damages)) return;																				// IF ATTACKER HAS NO DAMAGE COMPONENT, return
-	Damage& damage = com.damages[attacker];																								// get damage component
-	if (now - damage.lastDamageDealtTime < STAT_CHANGE_COOLDOWN) return;																// IF WITHIN COOLDOWN, return
-	if (damage.amount > 0) {													 														// IF DAMAGE AMOUNT > 0
-		if (isValidComponent(victim, com.audios)) {																						// IF VICTIM HAS AUDIO COMPONENT								
-			audioString = com.audios[victim].damageSound;																				// get damage sound
-			if (!audioString.empty() && loadedSounds.count(audioString)) playAudio(audioString, DEFAULT_SFX_VOLUME);					// play sound
-		}
+	return false;																							// ELSE return false
+}
+
+void MyEngineSystem::collectContactPairs()
+{
+	contactPairs.clear();																				// clear pairs, keeps capacity
+	for (const CollisionChunk& chunk : collisionChunks)													// FOR EACH CHUNK
+		for (const CollisionContact& contact : chunk.contacts)											// FOR EACH CONTACT
+			if (contact.other != 0) contactPairs.push_back(pairKey(contact.primary, contact.other));	// IF ENTITY CONTACT, add its pair
+	std::sort(contactPairs.begin(), contactPairs.end());												// sort keys
+	contactPairs.erase(std::unique(contactPairs.begin(), contactPairs.end()), contactPairs.end());		// one entry per pair
+	contactPairResolved.assign(contactPairs.size(), false);												// none resolved yet
+}
+
+void MyEngineSystem::applyCollisionContacts(const std::vector<CollisionContact>& contacts)
+{
+	PROFILE_ZONE("collisionResponses");
+	for (const CollisionContact& contact : contacts) {														// FOR EACH CONTACT, in the order it was found
+		const Transform* transform = component.transforms.find(contact.primary);							// find mover transform
+		if (!transform || !transform->active) continue;														// IF DEACTIVATED BY AN EARLIER RESPONSE, skip
+		if (contact.other == 0) { deactivateProjectile(contact.primary); continue; }						// IF WALL CONTACT, deactivate projectile
+		const Transform* otherTransform = component.transforms.find(contact.other);							// find other transform
+		if (!otherTransform || !otherTransform->active) continue;											// IF DEACTIVATED BY AN EARLIER RESPONSE, skip
+		processCollisionEntities(contact.primary, contact.other);											// process collision
 	}
-	if (isValidComponent(attacker, com.audios)) {																						// IF ATTACKER HAS AUDIO COMPONENT
-		audioString = com.audios[attacker].attackingSound;																				// get attacking sound
-		if (!audioString.empty() && loadedSounds.count(audioString)) playAudio(audioString, DEFAULT_SFX_VOLUME);						// play sound
+}
+
+void MyEngineSystem::processCollisionEntities(Entity primary, Entity other)
+{
+	const std::uint64_t key = pairKey(primary, other);																// order independent pair key
+	auto pair = std::lower_bound(contactPairs.begin(), contactPairs.end(), key);									// find pair among this step's contacts
+	if (pair != contactPairs.end() && *pair == key) {																// IF PAIR IS A CONTACT THIS STEP
+		std::vector<bool>::reference resolved = contactPairResolved[pair - contactPairs.begin()];					// get its resolved flag
+		if (resolved) return;																						// IF ALREADY RESOLVED THIS STEP, return
+		resolved = true;																							// mark resolved
 	}
-	changeEntityHealth(victim, -damage.amount);																							// reduce victim health
-	if (getEntityTag(attacker) == EntityTag::NPC) changeEntityHealth(attacker, damage.amount / 2);										// IF ATTACKER IS NPC, heal on hit
-	damage.lastDamageDealtTime = now;																									// update last damage time
-	if (getEntityTag(attacker) == EntityTag::PROJECTILE) deactivateProjectile(attacker);												// IF FOUND, deactivate projectile
-	if (getEntityTag(attacker) == EntityTag::HEALTH) destroyEntity(attacker);															// IF HEALTH PICKUP, destroy entity
-	return;																																// return
+	const CollisionResponse& response = collisionResponses[int(getEntityTag(primary))][int(getEntityTag(other))];	// look up response by tag pair
+	if (!response.handler) return;																					// IF NO RESPONSE FOR PAIR, return
+	if (response.swapped) (this->*response.handler)(other, primary);												// IF TABLE ENTRY IS MIRRORED, swap roles
+	else (this->*response.handler)(primary, other);																	// ELSE call in order
+}
+
+void MyEngineSystem::setCollisionResponse(EntityTag first, EntityTag second, CollisionHandler handler)
+{
+	collisionResponses[int(second)][int(first)] = CollisionResponse{ handler, true };						// mirrored entry, roles swapped
+	collisionResponses[int(first)][int(second)] = CollisionResponse{ handler, false };						// entry in handler order, wins when tags match
+}
+
+void MyEngineSystem::buildCollisionResponses()
+{
+	const EntityTag tags[] = { EntityTag::Unknown, EntityTag::PC, EntityTag::NPC, EntityTag::AMMO,				// all tags
+		EntityTag::HEALTH, EntityTag::PROJECTILE, EntityTag::ENDLEVEL };
+	// lowest priority first, later entries override earlier ones for the same pair
+	setCollisionResponse(EntityTag::NPC, EntityTag::PC, &MyEngineSystem::applyDamage);							// NPC attacks player
+	for (EntityTag tag : tags) setCollisionResponse(EntityTag::PROJECTILE, tag, &MyEngineSystem::applyDamage);	// projectile hits anything
+	for (EntityTag tag : tags) setCollisionResponse(EntityTag::HEALTH, tag, &MyEngineSystem::onHealthPickup);	// health pickup heals anything
+	setCollisionResponse(EntityTag::HEALTH, EntityTag::NPC, nullptr);											// except NPCs
+	for (EntityTag tag : tags) setCollisionResponse(EntityTag::AMMO, tag, &MyEngineSystem::increaseAmmo);		// ammo pickup collected by anything with ammo
+	setCollisionResponse(EntityTag::ENDLEVEL, EntityTag::PC, &MyEngineSystem::onEndLevelReached);				// player reaches end of level
+}
+
+void MyEngineSystem::onEndLevelReached(Entity trigger, Entity player)
+{
+	if (levelClearPending) return;																									// IF ALREADY REACHED THIS STEP, the trigger stays until the clear, return
+	if (currentLevel + 1 >= levelsCount) {																							// IF LAST LEVEL 
+		if (getNPCCount() <= 0) gameCompleted = true;																				// IF NO NPCS LEFT, set game completed
+		return;																															// return
+	}
+	++currentLevel;																													// increment level
+	levelChanging = true;																											// set level changing
+	const Audio* audio = component.audios.find(trigger);																			// find trigger audio
+	if (audio && !audio->attackingSound.empty()) playAudio(audio->attackingSound, DEFAULT_SFX_VOLUME);								// IF END TRIGGER HAS ATTACKING SOUND, play sound
+	levelClearPending = true;																										// clear level except player once systems finish,
+	levelClearKeeper = player;																										// clearing here would reorder pools being iterated
+}
+
+void MyEngineSystem::onHealthPickup(Entity pickup, Entity other)
+{
+	const Health* health = component.healths.find(other);													// find health of victim
+	if (!health || health->currentHealth >= health->maxHealth) return;										// IF NO HEALTH OR HEALTH IS MAX, return
+	applyDamage(pickup, other);																				// pickup damage is negative, so this heals
+}
+
+void MyEngineSystem::applyDamage(Entity attacker, Entity victim)
+{
+	Damage* damage = component.damages.find(attacker);																					// find damage component
+	if (!damage) return;																												// IF ATTACKER HAS NO DAMAGE COMPONENT, return
+	if (now - damage->lastDamageDealtTime < STAT_CHANGE_COOLDOWN) return;																// IF WITHIN COOLDOWN, return
+	if (damage->amount > 0) {																											// IF DAMAGE AMOUNT > 0
+		const Audio* audio = component.audios.find(victim);																				// find victim audio
+		if (audio && !audio->damageSound.empty() && loadedSounds.count(audio->damageSound)) playAudio(audio->damageSound, DEFAULT_SFX_VOLUME);	// IF VICTIM HAS DAMAGE SOUND, play sound
+	}
+	const Audio* audio = component.audios.find(attacker);																				// find attacker audio
+	if (audio && !audio->attackingSound.empty() && loadedSounds.count(audio->attackingSound)) playAudio(audio->attackingSound, DEFAULT_SFX_VOLUME);	// IF ATTACKER HAS ATTACKING SOUND, play sound
+	changeEntityHealth(victim, -damage->amount);																						// reduce victim health
+	if (hasAnyOf(attacker, NPC_BIT)) changeEntityHealth(attacker, damage->amount / 2);													// IF ATTACKER IS NPC, heal on hit
+	damage->lastDamageDealtTime = now;																									// update last damage time
+	if (hasAnyOf(attacker, PROJECTILE_BIT)) deactivateProjectile(attacker);																// IF PROJECTILE, deactivate projectile
+	if (hasAnyOf(attacker, HEALTH_PICKUP_BIT)) destroyEntity(attacker);																	// IF HEALTH PICKUP, destroy entity
 }
 
 void MyEngineSystem::updateAnimationStates(Component& com, float deltaTime)
 {
-	for (auto& animStateComp : com.animationStates) {														// FOR EACH ANIMATION STATE
-		Entity entity = animStateComp.first;																// get entity
-		if (!isValidComponent(entity, com.velocities)) continue;											// IF NO VELOCITY, skip
-		if (!isValidComponent(entity, com.transforms)) continue;											// IF NO TRANSFORM, skip
-		if (isValidComponent(entity, com.dying)) if (com.dying[entity]) continue;							// IF DYING, skip
-		if (!isValidComponent(entity, com.animations)) continue;											// IF NO ANIMATION, skip
-		Animation& animation = com.animations[entity];														// get Animation
-		AnimationState& animState = animStateComp.second;													// get animation state
-		Transform& transform = com.transforms[entity];														// get Transform
-		const Velocity& velocity = com.velocities[entity];													// get velocity
+	PROFILE_ZONE("updateAnimationStates");
+	com.view<AnimationState, Velocity, Transform, Animation>().each([&](Entity entity, AnimationState& animState,	// FOR EACH ANIMATED MOVER
+		const Velocity& velocity, Transform& transform, Animation& animation) {
+		const Dying* dying = com.dying.find(entity);														// find dying state
+		if (dying && dying->isDying) return;																// IF DYING, skip
 		std::string newAnim;																				// new animation name
 		if (velocity.x == 0 && velocity.y == 0) 															// IF NOT MOVING
 			if (animState.previousAnimation.find("_up") != std::string::npos)								// IF UP
@@ -236,43 +370,54 @@ void MyEngineSystem::updateAnimationStates(Component& com, float deltaTime)
 				else newAnim = animState.walk_up;															// ELSE MOVING UP - use up animation
 			animState.previousAnimation = newAnim;															// store previous animation
 		}
-		if (animation.name == newAnim) continue;															// IF SAME ANIMATION, skip
+		if (animation.name == newAnim) return;																// IF SAME ANIMATION, skip
 		animation.name = newAnim;																			// set new animation name
 		animation.currentFrame = {};																		// reset current frame
 		animation.animTimer = {};																			// reset timer
 		animation.frameDuration = 0.1f;																		// set frame duration
 		animation.loop = true;																				// set loop to true
 		animation.frameCount = 1;																			// set frame count to 1
-		if (!isValidComponent(entity, com.sprites)) continue; 												// IF SPRITE FOUND
+		if (!com.sprites.has(entity)) return;																// IF NO SPRITE, skip
 		auto foundSprite = loadedSprites.find(newAnim);														// find Sprite by animation name
 		animation.loop = foundSprite->second.loop;															// set loop from sprite
 		animation.frameCount = foundSprite->second.frameCount;												// set frame count from sprite
-	}
+	});
 }
 
 void MyEngineSystem::animationSystem(Component& com, float deltaTime)
 {
-	for (auto& foundAnim : com.animations) {																// FOR EACH ANIMATION
-		Entity entity = foundAnim.first;																	// get entity
-		Animation& anim = foundAnim.second;																	// get animation
-		float frameDur = anim.frameDuration;																// frame duration
-		anim.animTimer += deltaTime;																		// increase timer
-		if (frameDur <= 0.0f) frameDur = 0.1f;																// IF FRAME DURATION <= 0, set to default
-		while (anim.animTimer >= frameDur && frameDur > 0.0f) {												// WHILE TIME TO ADVANCE FRAME
-			anim.animTimer -= frameDur;																		// decrease timer
-			anim.currentFrame++;																			// increment frame
-			if (anim.currentFrame >= anim.frameCount) 														// IF PAST LAST FRAME
-				if (anim.loop) anim.currentFrame = {};														// IF LOOPING, reset to first frame
-				else anim.currentFrame = anim.frameCount - 1;												// ELSE stay on last frame
+	PROFILE_ZONE("animationSystem");
+	std::vector<Animation>& animations = com.animations.components();										// animations, split into chunks
+	parallelFor(animations.size(), [&](size_t begin, size_t end) {											// FOR EACH CHUNK OF ANIMATIONS
+		for (size_t i = begin; i < end; ++i) {																// FOR EACH ANIMATION IN CHUNK
+			Animation& anim = animations[i];																// get animation
+			float frameDur = anim.frameDuration;															// frame duration
+			anim.animTimer += deltaTime;																	// increase timer
+			if (frameDur <= 0.0f) frameDur = 0.1f;															// IF FRAME DURATION <= 0, set to default
+			while (anim.animTimer >= frameDur && frameDur > 0.0f) {											// WHILE TIME TO ADVANCE FRAME
+				anim.animTimer -= frameDur;																	// decrease timer
+				anim.currentFrame++;																		// increment frame
+				if (anim.currentFrame >= anim.frameCount)													// IF PAST LAST FRAME
+					if (anim.loop) anim.currentFrame = {};													// IF LOOPING, reset to first frame
+					else anim.currentFrame = anim.frameCount - 1;											// ELSE stay on last frame
+			}
 		}
-	}
+	});
+}
+
+void MyEngineSystem::parallelFor(size_t count, const std::function<void(size_t, size_t)>& body)
+{
+	if (count == 0) return;																					// IF NOTHING TO DO, return
+	if (!jobs || count <= JOB_CHUNK_SIZE) { body(0, count); return; }										// IF NO JOB SYSTEM OR ONE CHUNK, run here
+	jobs->wait(jobs->parallelFor(count, JOB_CHUNK_SIZE, body));												// ELSE spread chunks over the workers and help until done
 }
 
 void MyEngineSystem::processPendingDeaths()
 {
+	PROFILE_ZONE("processPendingDeaths");
 	std::vector<Entity> toCheck;																			// entities to check
 	toCheck.reserve(component.dying.size());																// reserve space
-	for (auto& entry : component.dying) if (entry.second) toCheck.push_back(entry.first);					// collect dying entities
+	for (auto entry : component.dying) if (entry.second.isDying) toCheck.push_back(entry.first);			// collect dying entities
 	for (Entity entity : toCheck) {																			// FOR EACH ENTITY TO CHECK
 		if (!isValidComponent(entity, component.animations)) { finaliseDeath(entity); continue; }			// IF NO ANIMATION, finalise death
 		Animation& anim = component.animations[entity];														// get animation
@@ -284,11 +429,12 @@ void MyEngineSystem::processPendingDeaths()
 void MyEngineSystem::finaliseDeath(Entity entity)
 {
 	component.dying.erase(entity);																			// unmark dying
-	if (getEntityTag(entity) == EntityTag::PC) {															// IF PLAYER CHARACTER
+	if (hasAnyOf(entity, PC_BIT)) {																			// IF PLAYER CHARACTER
 		if (isValidComponent(entity, component.transforms)) {												// IF NO TRANSFORM, return
 			Transform& transform = component.transforms[entity];											// get transform
 			transform.position = transform.startPosition;													// reset position
 			transform.newPosition = transform.position;														// reset new position
+			transform.previousPosition = transform.position;												// snap, no interpolation across the respawn
 		}
 		if (isValidComponent(entity, component.healths)) {													// IF HAS HEALTH COMPONENT
 			Health& health = component.healths[entity];														// get health component
@@ -296,7 +442,7 @@ void MyEngineSystem::finaliseDeath(Entity entity)
 		}
 		return;																								// return without destroying player
 	}
-	if (getEntityTag(entity) == EntityTag::NPC) {															// IF NPC
+	if (hasAnyOf(entity, NPC_BIT)) {																		// IF NPC
 		int npcScoreValue = DEFAULT_NPC_SCORE_VALUE;														// default score value
 		if (isValidComponent(entity, component.scores)) npcScoreValue = component.scores[entity].amount;	// IF HAS SCORE COMPONENT, get score value
 		score += npcScoreValue;																				// increase score
@@ -304,63 +450,74 @@ void MyEngineSystem::finaliseDeath(Entity entity)
 	}
 }
 
-void MyEngineSystem::render(std::shared_ptr<GraphicsEngine> gfx)
+void MyEngineSystem::render(std::shared_ptr<GraphicsEngine> gfx, float interpolation, float frameTime)
 {
 	if (!gfx) return;																											// IF NO GRAPHICS ENGINE, return
-	updateCamera(gfx);																											// update camera position
+	this->interpolation = interpolation;																						// blend factor for renderPosition
+	updateCamera(gfx, frameTime);																								// update camera position, smoothed over real time
+	gfx->beginSpriteBatch();																									// batch tiles and sprites, consecutive draws from one sheet share a draw call
 	renderTiles(gfx);																											// render background tiles first, cheap way to handle layers
 	struct RenderItem { Entity entity; Sprite* sprite; Transform* transform; Animation* anim; int layer; };						// render item (with layer)
-	std::vector<RenderItem> list;																								// list of render items
-	list.reserve(component.sprites.size());																						// reserve space from sprite count
-	for (auto& spriteComp : component.sprites) {																				// FOR EACH SPRITE COMPONENT
-		Entity entity = spriteComp.first;																						// get entity by the first part of the pair
-		Sprite& sprite = spriteComp.second;																						// get sprite by the second part of the pair
-		if (!isValidComponent(entity, component.transforms)) continue; 															// IF NO TRANSFORM, skip
-		Transform& transform = component.transforms[entity];																	// get transform
-		if (!transform.active) continue;																						// IF NOT ACTIVE, skip
-		Animation* anim = nullptr;																								// animation pointer
-		if (isValidComponent(entity, component.animations)) anim = &component.animations[entity];								// IF HAS ANIMATION, get pointer
-		list.push_back({ entity, &sprite, &transform, anim, transform.layer });													// add to render list with layer	
-	}
-	std::stable_sort(list.begin(), list.end(), [](const RenderItem& a, const RenderItem& b) {									// sort render list
-		if (a.layer != b.layer) return a.layer < b.layer;																		// IF LAYERS DIFFER, sort by layer
-		return a.transform->position.y < b.transform->position.y;																// return by Y position
+	struct BarItem { Entity entity; int x, y, w, h; };																			// health bar drawn after the sprite batch
+	std::vector<BarItem> bars;																									// list of health bars
+	{
+		PROFILE_ZONE("renderSprites");																							// profiler zone for the sprite pass
+		std::vector<RenderItem> list;																							// list of render items
+		list.reserve(component.sprites.size());																					// reserve space from sprite count
+		Dimension2i window = gfx->getCurrentWindowSize();																		// get window size
+		SDL_Rect viewRect = { roundToInt(cameraPosition.x), roundToInt(cameraPosition.y), window.w, window.h };					// visible world area
+		view<Sprite, Transform>().each([&](Entity entity, Sprite& sprite, Transform& transform) {								// FOR EACH SPRITE WITH TRANSFORM
+			if (!transform.active) return;																						// IF NOT ACTIVE, skip
+			int width = roundToInt(sprite.frameW * transform.scale), height = roundToInt(sprite.frameH * transform.scale);		// scaled size
+			Vector2f position = renderPosition(transform);																		// interpolated position
+			SDL_Rect bounds = { roundToInt(position.x), roundToInt(position.y) - height / 2, width, height + height / 2 };		// sprite and health bar area
+			if (SDL_HasIntersection(&bounds, &viewRect) == SDL_FALSE) return;													// IF OFF SCREEN, skip before sorting
+			Animation* anim = component.animations.find(entity);																// animation pointer, nullptr if none
+			list.push_back({ entity, &sprite, &transform, anim, transform.layer });												// add to render list with layer	
 		});
-	for (auto& rendered : list) {																								// FOR EACH RENDER ITEM
-		Sprite* spritePtr = rendered.sprite;																					// default sprite pointer
-		int currentFrame = {};																									// zero intialise current frame
-		if (rendered.anim) {																									// IF HAS ANIMATION
-			if (loadedSprites.find(rendered.anim->name) != loadedSprites.end())													// IF SPRITE FOUND BY ANIMATION NAME
-				spritePtr = &loadedSprites[rendered.anim->name];																// set sprite pointer to that sprite
-			currentFrame = rendered.anim->currentFrame;																			// get current frame from animation
-		}
-		Sprite& sprite = *spritePtr;																							// get sprite reference
-		int frameIndex = sprite.startFrame + currentFrame;																		// calculate frame index
-		int columns = 1;																										// default columns
-		if (sprite.frameW > 0) {																								// IF FRAME WIDTH > 0
-			columns = sprite.textureWidth / sprite.frameW;																		// calculate columns
-			if (columns <= 0) columns = 1;																						// prevent division by zero
-		}
-		int xPos = (frameIndex % columns) * sprite.frameW;																		// get X position in texture sprite sheet
-		SDL_Rect src = { xPos, 0, sprite.frameW, sprite.frameH };																// source rectangle
-		int width = roundToInt(sprite.frameW * rendered.transform->scale);														// scaled width
-		int height = roundToInt(sprite.frameH * rendered.transform->scale);														// scaled height
-		int posX = roundToInt(rendered.transform->position.x - cameraPosition.x);												// screen X
-		int posY = roundToInt(rendered.transform->position.y - cameraPosition.y);												// screen Y
-		SDL_Rect dst = { posX, posY, width, height };																			// destination rectangle
-		setEntityColliderRect(rendered.entity, rendered.transform->position.x, rendered.transform->position.y, width, height);	// set collider rect
-		SDL_RendererFlip flip = SDL_FLIP_NONE;																					// no flip
-		if (rendered.transform->flipH) flip = SDL_FLIP_HORIZONTAL;																// horizontal flip
-		double angle = {};																										// zero intialise angle
-		if (getEntityTag(rendered.entity) == EntityTag::PROJECTILE) {															// IF PROJECTILE
-			if (isValidComponent(rendered.entity, component.velocities)) {														// IF HAS VELOCITY
-				Velocity& velocity = component.velocities[rendered.entity];														// get velocity
-				angle = std::atan2(velocity.y, velocity.x) * (180.0 / M_PI) - 90.0;												// calculate angle in degrees
+		std::stable_sort(list.begin(), list.end(), [](const RenderItem& a, const RenderItem& b) {								// sort render list
+			if (a.layer != b.layer) return a.layer < b.layer;																	// IF LAYERS DIFFER, sort by layer
+			return a.transform->position.y < b.transform->position.y;															// return by Y position
+			});
+		for (auto& rendered : list) {																							// FOR EACH RENDER ITEM
+			Sprite* spritePtr = rendered.sprite;																				// default sprite pointer
+			int currentFrame = {};																								// zero intialise current frame
+			if (rendered.anim) {																								// IF HAS ANIMATION
+				if (loadedSprites.find(rendered.anim->name) != loadedSprites.end())												// IF SPRITE FOUND BY ANIMATION NAME
+					spritePtr = &loadedSprites[rendered.anim->name];															// set sprite pointer to that sprite
+				currentFrame = rendered.anim->currentFrame;																		// get current frame from animation
+			}
+			Sprite& sprite = *spritePtr;																						// get sprite reference
+			int frameIndex = sprite.startFrame + currentFrame;																	// calculate frame index
+			int columns = 1;																									// default columns
+			if (sprite.frameW > 0) {																							// IF FRAME WIDTH > 0
+				columns = sprite.textureWidth / sprite.frameW;																	// calculate columns
+				if (columns <= 0) columns = 1;																					// prevent division by zero
 			}
+			int xPos = (frameIndex % columns) * sprite.frameW;																	// get X position in texture sprite sheet
+			SDL_Rect src = { sprite.atlasX + xPos, sprite.atlasY, sprite.frameW, sprite.frameH };								// source rectangle
+			int width = roundToInt(sprite.frameW * rendered.transform->scale);													// scaled width
+			int height = roundToInt(sprite.frameH * rendered.transform->scale);													// scaled height
+			Vector2f position = renderPosition(*rendered.transform);															// interpolated position
+			int posX = roundToInt(position.x - cameraPosition.x);																// screen X
+			int posY = roundToInt(position.y - cameraPosition.y);																// screen Y
+			SDL_Rect dst = { posX, posY, width, height };																		// destination rectangle
+			SDL_RendererFlip flip = SDL_FLIP_NONE;																				// no flip
+			if (rendered.transform->flipH) flip = SDL_FLIP_HORIZONTAL;															// horizontal flip
+			double angle = {};																									// zero intialise angle
+			if (hasAnyOf(rendered.entity, PROJECTILE_BIT)) {																	// IF PROJECTILE
+				if (const Velocity* velocity = component.velocities.find(rendered.entity))										// IF HAS VELOCITY
+					angle = std::atan2(velocity->y, velocity->x) * (180.0 / M_PI) - 90.0;										// calculate angle in degrees
+			}
+			gfx->drawSprite(sprite.texture, src, dst, angle, flip);																// queue sprite
+			int healthBarposY = posY - (height / 2);																			// adjust posY for bar rendering
+			if (component.healthBars.has(rendered.entity)) bars.push_back({ rendered.entity, posX, healthBarposY, sprite.frameW, sprite.frameH });	// IF HAS HEALTH BAR, queue bar
 		}
-		gfx->drawTexture(sprite.texture, &src, &dst, angle, nullptr, flip);														// draw texture
-		int healthBarposY = posY - (height / 2);																				// adjust posY for bar rendering
-		renderHealthBar(gfx, rendered.entity, posX, healthBarposY, sprite.frameW, sprite.frameH);								// render health bar
+		gfx->endSpriteBatch();																									// submit sprites
+	}
+	{
+		PROFILE_ZONE("renderHealthBars");																						// profiler zone for the health bar pass
+		for (const BarItem& bar : bars) renderHealthBar(gfx, bar.entity, bar.x, bar.y, bar.w, bar.h);							// render health bars on top of sprites
 	}
 }
 
@@ -382,21 +539,108 @@ void MyEngineSystem::renderHealthBar(std::shared_ptr<GraphicsEngine> gfx, Entity
 void MyEngineSystem::loadSprite(const std::string& name, const std::string& filename, int frameW, int frameH, int frames, int startFrame, bool loop, float scale, SDL_Color transparent)
 {
 	if (loadedSprites.count(name)) return;																	// IF SPRITE ALREADY LOADED, return
-	SDL_Texture* texture = ResourceManager::loadTexture(filename, transparent);								// load texture
+	if (headless) { loadedSprites[name] = makeSprite(frameW, frameH, frames, startFrame, loop, scale); return; }	// IF HEADLESS, frame data only
+	SDL_Texture* texture = ResourceManager::loadTexture(filename, transparent, true);						// load texture, keeping the decoded sheet for buildSpriteAtlas
 	if (!texture) return;																					// IF FAILED TO LOAD TEXTURE, return
-	int width = {}, height = {};																			// zero initialise width and height
-	SDL_QueryTexture(texture, nullptr, nullptr, &width, &height);											// query texture 
+	addSprite(name, texture, makeSprite(frameW, frameH, frames, startFrame, loop, scale), SpriteSource{ filename, transparent });	// store Sprite
+}
+
+void MyEngineSystem::loadSpriteAsync(const std::string& name, const std::string& filename, int frameW, int frameH, int frames, int startFrame, bool loop, float scale, SDL_Color transparent)
+{
+	if (loadedSprites.count(name)) return;																			// IF SPRITE ALREADY LOADED, return
+	if (headless) { loadSprite(name, filename, frameW, frameH, frames, startFrame, loop, scale, transparent); return; }	// IF HEADLESS, nothing to load
+	Sprite sprite = makeSprite(frameW, frameH, frames, startFrame, loop, scale);									// everything but the texture
+	SpriteSource source = { filename, transparent };																// source image for the atlas
+	ResourceManager::loadTextureAsync(filename, transparent, [this, name, sprite, source](SDL_Texture* texture) {	// ON TEXTURE UPLOADED, on the render thread
+		if (!texture) return;																						// IF FAILED TO LOAD TEXTURE, return
+		if (loadedSprites.count(name)) { ResourceManager::releaseTexture(texture); return; }						// IF LOADED MEANWHILE, keep the first
+		addSprite(name, texture, sprite, source);																	// store Sprite
+	}, true);																										// keep the decoded sheet, buildSpriteAtlas packs it without decoding again
+}
+
+MyEngineSystem::Sprite MyEngineSystem::makeSprite(int frameW, int frameH, int frames, int startFrame, bool loop, float scale)
+{
 	Sprite sprite;																							// create Sprite
-	sprite.texture = texture;																				// set texture
 	sprite.frameW = frameW;																					// set frame width
 	sprite.frameH = frameH;																					// set frame height
 	sprite.frameCount = frames;																				// set frame count
-	sprite.textureWidth = width;																			// set texture width to width which is queried
-	sprite.textureHeight = height;																			// set texture height to height which is queried
 	sprite.startFrame = startFrame;																			// set start frame
 	sprite.loop = loop;																						// set loop
 	sprite.scale = scale;																					// set scale
+	return sprite;
+}
+
+void MyEngineSystem::addSprite(const std::string& name, SDL_Texture* texture, Sprite sprite, const SpriteSource& source)
+{
+	int width = {}, height = {};																			// zero initialise width and height
+	SDL_QueryTexture(texture, nullptr, nullptr, &width, &height);											// query texture
+	sprite.texture = texture;																				// set texture
+	sprite.textureWidth = width;																			// set texture width to width which is queried
+	sprite.textureHeight = height;																			// set texture height to height which is queried
 	loadedSprites[name] = std::move(sprite);																// store Sprite
+	spriteSources[name] = source;																			// remember source image for the atlas
+}
+
+void MyEngineSystem::onTextureReloaded(SDL_Texture* oldTexture, SDL_Texture* newTexture)
+{
+	if (oldTexture != newTexture) {																			// IF TEXTURE RECREATED AT A NEW SIZE, repoint sprites
+		int width = {}, height = {};																		// zero initialise width and height
+		SDL_QueryTexture(newTexture, nullptr, nullptr, &width, &height);									// query new texture
+		auto repoint = [&](Sprite& sprite) {																// move sprite to the new texture
+			if (sprite.texture != oldTexture) return;														// IF OTHER TEXTURE, skip
+			sprite.texture = newTexture;																	// set texture
+			sprite.textureWidth = width;																	// set texture width
+			sprite.textureHeight = height;																	// set texture height
+		};
+		for (auto& loaded : loadedSprites) repoint(loaded.second);											// loaded sprites
+		for (Sprite& sprite : component.sprites.components()) repoint(sprite);								// sprite components already spawned
+	}
+	invalidateTileChunks(SDL_Rect{ 0, 0, int(worldWidth), int(worldHeight) });								// baked tiles hold the old pixels
+}
+
+void MyEngineSystem::unloadSprite(const std::string& name)
+{
+	auto foundSprite = loadedSprites.find(name);															// find sprite
+	if (foundSprite == loadedSprites.end()) return;															// IF NOT LOADED, return
+	ResourceManager::releaseTexture(foundSprite->second.texture);											// drop this sprite's texture reference, sheets stay while other sprites use them
+	loadedSprites.erase(foundSprite);																		// forget sprite
+	spriteSources.erase(name);																				// forget source image
+	invalidateTileChunks(SDL_Rect{ 0, 0, int(worldWidth), int(worldHeight) });								// tiles using it are no longer drawn
+}
+
+void MyEngineSystem::buildSpriteAtlas(int pageSize)
+{
+	std::vector<std::pair<std::string, SDL_Color>> images;													// distinct sheets not packed yet
+	std::map<SDL_Texture*, size_t> imageOf;																	// sheet texture to image index
+	for (auto& loaded : loadedSprites) {																	// FOR EACH LOADED SPRITE
+		auto source = spriteSources.find(loaded.first);														// find source image
+		if (source == spriteSources.end() || source->second.packed) continue;								// IF UNKNOWN OR ALREADY PACKED, skip
+		if (imageOf.count(loaded.second.texture)) continue;													// IF SHEET ALREADY LISTED, skip
+		imageOf[loaded.second.texture] = images.size();														// map sheet to image
+		images.push_back({ source->second.file, source->second.transparent });								// add image
+	}
+	if (images.empty()) return;																				// IF NOTHING TO PACK, return
+	std::vector<AtlasRegion> regions = ResourceManager::loadTextureAtlas(images, pageSize);					// pack sheets into pages
+	auto repack = [&](Sprite& sprite) {																		// point sprite at its sheet inside the atlas, false if not packed
+		auto image = imageOf.find(sprite.texture);															// find sheet
+		if (image == imageOf.end()) return false;															// IF NOT PACKED, keep sprite as is
+		sprite.texture = regions[image->second].texture;													// atlas page
+		sprite.atlasX = regions[image->second].rect.x;														// sheet X in page
+		sprite.atlasY = regions[image->second].rect.y;														// sheet Y in page
+		return true;
+	};
+	for (Sprite& sprite : component.sprites.components()) repack(sprite);									// move sprite components already spawned
+	for (auto& loaded : loadedSprites) {																	// FOR EACH LOADED SPRITE
+		SDL_Texture* sheet = loaded.second.texture;															// sheet texture before packing
+		if (!repack(loaded.second)) continue;																// IF NOT PACKED, skip
+		ResourceManager::retainTexture(loaded.second.texture);												// sprite now uses the page
+		ResourceManager::releaseTexture(sheet);																// and no longer the sheet, freed with its last sprite
+		spriteSources[loaded.first].packed = true;															// mark packed
+	}
+	invalidateTileChunks(SDL_Rect{ 0, 0, int(worldWidth), int(worldHeight) });								// rebake tiles from the atlas
+#ifdef __DEBUG																								// Debug info
+	debug("MyEngineSystem::buildSpriteAtlas() packed sheets", int(images.size()));							// Log packed sheet count
+#endif																										// Debug info
 }
 
 void MyEngineSystem::attachSprite(Entity entity, const std::string& spriteName)
@@ -434,20 +678,134 @@ void MyEngineSystem::addGroundTile(const std::string& spriteName, int x, int y)
 	Tile tile;																								// create tile
 	tile.x = x; tile.y = y; tile.spriteName = spriteName;													// set tile properties
 	groundTiles.push_back(std::move(tile));																	// add tile to ground tiles
+	tileCellsDirty = true;																					// regroup tiles before next render
+	auto foundSprite = loadedSprites.find(spriteName);														// find sprite for the tile size
+	int width = foundSprite != loadedSprites.end() ? foundSprite->second.frameW : int(TILE_SIZE);			// tile width
+	int height = foundSprite != loadedSprites.end() ? foundSprite->second.frameH : int(TILE_SIZE);			// tile height
+	invalidateTileChunks(SDL_Rect{ x, y, width, height });													// rebake chunks under the tile
+}
+
+void MyEngineSystem::addStaticTile(const std::string& spriteName, int x, int y)
+{
+	staticTiles.set(x / int(TILE_SIZE), y / int(TILE_SIZE));												// mark cell as solid
+	addGroundTile(spriteName, x, y);																		// walls are drawn with the ground tiles
 }
 
 void MyEngineSystem::renderTiles(std::shared_ptr<GraphicsEngine> gfx) {
+	PROFILE_ZONE("renderTiles");																			// profiler zone for the tile pass
 	if (!gfx) return;																						// IF NO GRAPHICS ENGINE, return
+	if (tileCellsDirty) buildTileCells();																	// IF TILES CHANGED, regroup by cell
+	if (tileCols <= 0 || tileRows <= 0) return;																// IF NO CELLS, return
 	Dimension2i window = gfx->getCurrentWindowSize();														// get window size
-	for (const Tile& tile : groundTiles) {																	// FOR EACH TILE
-		if (loadedSprites.find(tile.spriteName) == loadedSprites.end()) continue;							// IF SPRITE NOT FOUND, skip
-		const Sprite& sprite = loadedSprites[tile.spriteName];												// get Sprite
-		int screenX = roundToInt(tile.x - cameraPosition.x);												// screen X
-		int screenY = roundToInt(tile.y - cameraPosition.y);												// screen Y
-		SDL_Rect src = { 0, 0, sprite.frameW, sprite.frameH };												// source rectangle
-		SDL_Rect dst = { screenX, screenY, sprite.frameW, sprite.frameH };									// destination rectangle
-		gfx->drawTexture(sprite.texture, &src, &dst, 0.0, nullptr, SDL_FLIP_NONE);							// draw texture
+	if (!gfx->isRenderTargetSupported()) {																	// IF NO RENDER TARGETS, draw visible cells directly
+		int firstCol = std::max(0, int(std::floor(cameraPosition.x / TILE_SIZE)) - 1);						// first visible column, one extra for tiles wider than a cell
+		int firstRow = std::max(0, int(std::floor(cameraPosition.y / TILE_SIZE)) - 1);						// first visible row, one extra for tiles taller than a cell
+		int lastCol = std::min(tileCols - 1, int(std::floor((cameraPosition.x + window.w) / TILE_SIZE)));	// last visible column
+		int lastRow = std::min(tileRows - 1, int(std::floor((cameraPosition.y + window.h) / TILE_SIZE)));	// last visible row
+		drawTileCells(gfx, firstCol, firstRow, lastCol, lastRow, cameraPosition);							// queue visible tiles
+		return;
+	}
+	if (gfx->getRenderTargetResets() != seenRenderTargetResets) {											// IF RENDERER WIPED RENDER TARGETS, after a resize or fullscreen toggle on some backends
+		seenRenderTargetResets = gfx->getRenderTargetResets();												// remember this reset
+		invalidateTileChunks(SDL_Rect{ 0, 0, int(worldWidth), int(worldHeight) });							// rebake every chunk as it comes into view
+	}
+	const int chunkPixels = TILE_CHUNK_SIZE * int(TILE_SIZE);												// chunk side in pixels
+	int firstChunkCol = std::max(0, int(std::floor(cameraPosition.x / chunkPixels)));						// first visible chunk column
+	int firstChunkRow = std::max(0, int(std::floor(cameraPosition.y / chunkPixels)));						// first visible chunk row
+	int lastChunkCol = std::min(chunkCols - 1, int(std::floor((cameraPosition.x + window.w) / chunkPixels)));	// last visible chunk column
+	int lastChunkRow = std::min(chunkRows - 1, int(std::floor((cameraPosition.y + window.h) / chunkPixels)));	// last visible chunk row
+	for (int chunkRow = firstChunkRow; chunkRow <= lastChunkRow; ++chunkRow)								// FOR EACH VISIBLE CHUNK ROW
+		for (int chunkCol = firstChunkCol; chunkCol <= lastChunkCol; ++chunkCol) {							// FOR EACH VISIBLE CHUNK COLUMN
+			TileChunk& chunk = tileChunks[chunkRow * chunkCols + chunkCol];									// get chunk
+			int chunkX = chunkCol * chunkPixels, chunkY = chunkRow * chunkPixels;							// chunk world position
+			if (chunk.dirty && !bakeTileChunk(gfx, chunkCol, chunkRow)) {									// IF BAKING FAILED, draw the chunk's cells directly
+				int firstCol = chunkCol * TILE_CHUNK_SIZE, firstRow = chunkRow * TILE_CHUNK_SIZE;			// first cell of chunk
+				drawTileCells(gfx, firstCol, firstRow, std::min(tileCols - 1, firstCol + TILE_CHUNK_SIZE - 1), std::min(tileRows - 1, firstRow + TILE_CHUNK_SIZE - 1), cameraPosition);	// queue chunk tiles
+				continue;
+			}
+			SDL_Rect src = { 0, 0, chunkPixels, chunkPixels };												// whole chunk
+			SDL_Rect dst = { roundToInt(chunkX - cameraPosition.x), roundToInt(chunkY - cameraPosition.y), chunkPixels, chunkPixels };	// chunk on screen
+			gfx->drawSprite(chunk.texture, src, dst);														// queue chunk
+		}
+}
+
+void MyEngineSystem::drawTileCells(std::shared_ptr<GraphicsEngine> gfx, int firstCol, int firstRow, int lastCol, int lastRow, const Vector2f& origin)
+{
+	for (int row = firstRow; row <= lastRow; ++row)															// FOR EACH ROW
+		for (int col = firstCol; col <= lastCol; ++col) {													// FOR EACH COLUMN
+			int cell = row * tileCols + col;																// cell index
+			for (Uint32 i = tileCellStart[cell]; i < tileCellStart[cell + 1]; ++i) {						// FOR EACH TILE IN CELL
+				const Tile& tile = groundTiles[tileCellOrder[i]];											// get tile
+				auto foundSprite = loadedSprites.find(tile.spriteName);										// find sprite
+				if (foundSprite == loadedSprites.end()) continue;											// IF SPRITE NOT FOUND, skip
+				const Sprite& sprite = foundSprite->second;													// get Sprite
+				SDL_Rect src = { sprite.atlasX, sprite.atlasY, sprite.frameW, sprite.frameH };				// source rectangle
+				SDL_Rect dst = { roundToInt(tile.x - origin.x), roundToInt(tile.y - origin.y), sprite.frameW, sprite.frameH };	// destination rectangle
+				gfx->drawSprite(sprite.texture, src, dst);													// queue tile
+			}
+		}
+}
+
+bool MyEngineSystem::bakeTileChunk(std::shared_ptr<GraphicsEngine> gfx, int chunkCol, int chunkRow)
+{
+	TileChunk& chunk = tileChunks[chunkRow * chunkCols + chunkCol];											// get chunk
+	const int chunkPixels = TILE_CHUNK_SIZE * int(TILE_SIZE);												// chunk side in pixels
+	if (!chunk.texture) chunk.texture = GraphicsEngine::createRenderTarget(chunkPixels, chunkPixels);		// IF NO TEXTURE YET, create it
+	if (!chunk.texture) return false;																		// IF CREATION FAILED, caller draws the tiles itself
+	int firstCol = chunkCol * TILE_CHUNK_SIZE, firstRow = chunkRow * TILE_CHUNK_SIZE;						// first cell of chunk
+	Vector2f origin = { float(firstCol * int(TILE_SIZE)), float(firstRow * int(TILE_SIZE)) };				// chunk world position
+	gfx->setRenderTarget(chunk.texture);																	// draw into chunk, submits anything already queued
+	gfx->clearScreen(SDL_Color{ 0, 0, 0, 0 });																// clear to transparent
+	drawTileCells(gfx, std::max(0, firstCol - 1), std::max(0, firstRow - 1),								// queue chunk tiles, one extra cell for tiles overlapping from the left and top
+		std::min(tileCols - 1, firstCol + TILE_CHUNK_SIZE - 1), std::min(tileRows - 1, firstRow + TILE_CHUNK_SIZE - 1), origin);
+	gfx->setRenderTarget(nullptr);																			// back to the window, submits the chunk tiles
+	chunk.dirty = false;																					// chunk is up to date
+	return true;
+}
+
+void MyEngineSystem::invalidateTileChunks(const SDL_Rect& area)
+{
+	if (tileChunks.empty()) return;																				// IF NO CHUNKS YET, they start dirty
+	const int chunkPixels = TILE_CHUNK_SIZE * int(TILE_SIZE);													// chunk side in pixels
+	int firstChunkCol = std::max(0, area.x / chunkPixels), firstChunkRow = std::max(0, area.y / chunkPixels);	// first chunk touched
+	int lastChunkCol = std::min(chunkCols - 1, (area.x + area.w - 1) / chunkPixels);							// last chunk column touched
+	int lastChunkRow = std::min(chunkRows - 1, (area.y + area.h - 1) / chunkPixels);							// last chunk row touched
+	for (int chunkRow = firstChunkRow; chunkRow <= lastChunkRow; ++chunkRow)									// FOR EACH CHUNK ROW
+		for (int chunkCol = firstChunkCol; chunkCol <= lastChunkCol; ++chunkCol)								// FOR EACH CHUNK COLUMN
+			tileChunks[chunkRow * chunkCols + chunkCol].dirty = true;											// rebake before next draw
+}
+
+void MyEngineSystem::releaseTileChunks()
+{
+	for (TileChunk& chunk : tileChunks)																		// FOR EACH CHUNK
+		if (chunk.texture) SDL_DestroyTexture(chunk.texture);												// IF BAKED, destroy render target
+	tileChunks.clear();																						// drop chunks
+	chunkCols = chunkRows = 0;																				// no chunk grid
+}
+
+void MyEngineSystem::buildTileCells()
+{
+	tileCellsDirty = false;																						// reset dirty flag
+	tileCols = int((worldWidth + TILE_SIZE - 1) / TILE_SIZE);													// columns covering the world
+	tileRows = int((worldHeight + TILE_SIZE - 1) / TILE_SIZE);													// rows covering the world
+	tileCellStart.assign(size_t(std::max(0, tileCols * tileRows)) + 1, 0);										// reset offsets
+	tileCellOrder.resize(groundTiles.size());																	// one entry per tile
+	int cols = (tileCols + TILE_CHUNK_SIZE - 1) / TILE_CHUNK_SIZE, rows = (tileRows + TILE_CHUNK_SIZE - 1) / TILE_CHUNK_SIZE;	// chunks covering the cells
+	if (cols != chunkCols || rows != chunkRows) {																// IF CHUNK GRID CHANGED, start over with dirty chunks
+		releaseTileChunks();																					// destroy old render targets
+		chunkCols = cols; chunkRows = rows;																		// set chunk grid dimensions
+		tileChunks.resize(size_t(std::max(0, cols * rows)));													// one chunk per grid entry
 	}
+	if (tileCols <= 0 || tileRows <= 0) return;																	// IF NO WORLD, return
+	auto cellOf = [&](const Tile& tile) {																		// cell of tile, clamped to the grid
+		int col = std::min(std::max(tile.x / int(TILE_SIZE), 0), tileCols - 1);									// column
+		int row = std::min(std::max(tile.y / int(TILE_SIZE), 0), tileRows - 1);									// row
+		return row * tileCols + col;																			// cell index
+	};
+	for (const Tile& tile : groundTiles) ++tileCellStart[cellOf(tile) + 1];										// count tiles per cell
+	for (size_t cell = 1; cell < tileCellStart.size(); ++cell) tileCellStart[cell] += tileCellStart[cell - 1];	// prefix sum into offsets
+	std::vector<Uint32> next(tileCellStart.begin(), tileCellStart.end() - 1);									// next free slot per cell
+	for (Uint32 i = 0; i < groundTiles.size(); ++i) tileCellOrder[next[cellOf(groundTiles[i])]++] = i;			// place tiles, stable within a cell
 }
 
 void MyEngineSystem::changeEntityHealth(Entity entity, int amount) {
@@ -461,8 +819,8 @@ void MyEngineSystem::changeEntityHealth(Entity entity, int amount) {
 
 void MyEngineSystem::handleDeath(Entity entity, Health& health) {
 	health.currentHealth = 0;																				// set health to 0
-	if (isValidComponent(entity, component.dying)) if (component.dying[entity]) return;						// IF ALREADY DYING, return
-	component.dying[entity] = true;																			// mark as dying
+	if (isValidComponent(entity, component.dying)) if (component.dying[entity].isDying) return;				// IF ALREADY DYING, return
+	component.dying[entity] = Dying{ true };																// mark as dying
 	if (!isValidComponent(entity, component.animationStates)) return;										// IF NO ANIMATION STATE, return
 	AnimationState& componentState = component.animationStates[entity];										// get animation state
 	std::string previousAnim = componentState.previousAnimation;											// previous animation
@@ -491,14 +849,22 @@ void MyEngineSystem::handleDeath(Entity entity, Health& health) {
 }
 
 void MyEngineSystem::loadSound(const std::string& name, const std::string& filename) {
-	if (loadedSounds.count(name)) return;																	// already loaded
+	if (loadedSounds.count(name) || headless) return;														// already loaded, or no audio device
 	Mix_Chunk* chunk = ResourceManager::loadSound(filename);												// load sound
 	if (!chunk) return;																						// failed to load
 	loadedSounds[name] = chunk;																				// store sound
 }
 
+void MyEngineSystem::loadSoundAsync(const std::string& name, const std::string& filename) {
+	if (loadedSounds.count(name) || headless) return;														// already loaded, or no audio device
+	ResourceManager::loadSoundAsync(filename, [this, name](Mix_Chunk* chunk) {								// ON SOUND DECODED, on the render thread
+		if (chunk && !loadedSounds.count(name)) loadedSounds[name] = chunk;									// IF LOADED, store sound
+	});
+}
+
 void MyEngineSystem::playAudio(const std::string& name, int volume, int loops, int channel)
 {
+	if (headless) return;																					// IF HEADLESS, no audio device
 	auto sound = loadedSounds.find(name);																	// find sound from map
 	Mix_Chunk* chunk = nullptr;																				// sound chunk pointer
 	if (sound != loadedSounds.end()) chunk = sound->second;													// IF FOUND, get chunk
@@ -531,8 +897,8 @@ void MyEngineSystem::initProjectilePool(Entity owner, size_t poolSize)
 		int width = TILE_SIZE, height = TILE_SIZE;															// default dimensions
 		float scale = DEFAULT_ENTITY_SCALE;																	// default dimensions
 		scale = foundSprite->second.scale;																	// get scale
-		width = foundSprite->second.frameW * roundToInt(scale);												// get width
-		height = foundSprite->second.frameH * roundToInt(scale);											// get height
+		width = roundToInt(foundSprite->second.frameW * scale);												// get width, same as the drawn size
+		height = roundToInt(foundSprite->second.frameH * scale);											// get height, same as the drawn size
 		addComponentProjectileTag(entity, owner);															// add projectile tag component
 		addComponentTransform(entity, Vector2f(OFFSCREEN_X, OFFSCREEN_Y), scale);							// add transform component
 		addComponentCollider(entity, OFFSCREEN_X, OFFSCREEN_Y, width, height);								// add collider component
@@ -566,6 +932,9 @@ void MyEngineSystem::fireProjectile(Entity owner, const Vector2f& startPos, cons
 			transform.active = true;																		// set active
 			transform.position = startPos;																	// set start position
 			transform.newPosition = startPos;																// update new position
+			transform.previousPosition = startPos;															// snap, no interpolation from where it was pooled
+			if (const Collider* collider = component.colliders.find(entity))								// IF HAS COLLIDER
+				setEntityColliderRect(entity, startPos.x, startPos.y, collider->rect.w, collider->rect.h);	// move collider to start position
 			float dx = targetPos.x - startPos.x;															// delta x
 			float dy = targetPos.y - startPos.y;															// delta y
 			float length = std::sqrt(dx * dx + dy * dy);													// length
@@ -581,13 +950,16 @@ void MyEngineSystem::fireProjectile(Entity owner, const Vector2f& startPos, cons
 
 void MyEngineSystem::deactivateProjectile(Entity entity)
 {
-	if (getEntityTag(entity) != EntityTag::PROJECTILE) return;												// IF NOT A PROJECTILE, return
+	if (!hasAnyOf(entity, PROJECTILE_BIT)) return;															// IF NOT A PROJECTILE, return
 	component.velocities[entity] = Velocity{ 0.0f, 0.0f };													// reset velocity
 	Vector2f startPos = component.transforms[entity].startPosition;											// get start position
 	component.transforms[entity].position = Vector2f(startPos.x + cameraPosition.x, startPos.y + cameraPosition.y);	// move off-screen
 	component.transforms[entity].newPosition = component.transforms[entity].position;						// keep newPosition in sync
+	component.transforms[entity].previousPosition = component.transforms[entity].position;					// and previousPosition
 	component.transforms[entity].rotation = 0;																// reset rotation
 	component.transforms[entity].active = false;															// deactivate projectile
+	if (const Collider* collider = component.colliders.find(entity))										// IF HAS COLLIDER
+		setEntityColliderRect(entity, component.transforms[entity].position.x, component.transforms[entity].position.y, collider->rect.w, collider->rect.h);	// move collider off-screen too
 }
 
 void MyEngineSystem::updateCamera(std::shared_ptr<GraphicsEngine> gfx, float deltaTime)
@@ -600,11 +972,11 @@ void MyEngineSystem::updateCamera(std::shared_ptr<GraphicsEngine> gfx, float del
 		target.y = float(worldHeight) * 0.5f - float(window.h) * 0.5f;										// center y
 	}
 	else {																									// ELSE HAS PLAYER
-		Entity player = component.players.begin()->first;													// get first player entity
+		Entity player = component.players.entities().front();												// get first player entity
 		if (!isValidComponent(player, component.transforms)) return;										// IF NO TRANSFORM, return
-		const Transform& transform = component.transforms[player];											// get transform
-		target.x = transform.position.x - float(window.w) * 0.5f;											// center x on player
-		target.y = transform.position.y - float(window.h) * 0.5f;											// center y on player
+		Vector2f position = renderPosition(component.transforms[player]);									// get interpolated player position
+		target.x = position.x - float(window.w) * 0.5f;														// center x on player
+		target.y = position.y - float(window.h) * 0.5f;														// center y on player
 	}
 	float minX = std::min(0.0f, float(worldWidth) - float(window.w));										// min X
 	float maxX = std::max(0.0f, float(worldWidth) - float(window.w));										// max X
@@ -612,8 +984,15 @@ void MyEngineSystem::updateCamera(std::shared_ptr<GraphicsEngine> gfx, float del
 	float maxY = std::max(0.0f, float(worldHeight) - float(window.h) + DEFAULT_FONT_SIZE * 2);				// max Y (account for HUD)
 	if (target.x < minX) target.x = minX; if (target.x > maxX) target.x = maxX;								// clamp X
 	if (target.y < minY) target.y = minY; if (target.y > maxY) target.y = maxY;								// clamp Y
-	cameraPosition.x += (target.x - cameraPosition.x) * cameraSmoothing * deltaTime;						// smooth camera x
-	cameraPosition.y += (target.y - cameraPosition.y) * cameraSmoothing * deltaTime;						// smooth camera y
+	float smoothing = std::min(1.0f, cameraSmoothing * deltaTime);											// never overshoot after a long frame
+	cameraPosition.x += (target.x - cameraPosition.x) * smoothing;											// smooth camera x
+	cameraPosition.y += (target.y - cameraPosition.y) * smoothing;											// smooth camera y
+}
+
+Vector2f MyEngineSystem::renderPosition(const Transform& transform) const
+{
+	return Vector2f(transform.previousPosition.x + (transform.position.x - transform.previousPosition.x) * interpolation,	// blend x
+		transform.previousPosition.y + (transform.position.y - transform.previousPosition.y) * interpolation);				// blend y
 }
 
 void MyEngineSystem::increaseAmmo(Entity ammoPickup, Entity owner) {
@@ -658,27 +1037,39 @@ void MyEngineSystem::addComponentAudio(Entity entity, std::string damageSound, s
 }
 
 MyEngineSystem::EntityTag MyEngineSystem::getEntityTag(Entity entity) {
-	if (isValidComponent(entity, component.players)) return EntityTag::PC;									// IF HAS PLAYER COMPONENT, return PC
-	if (isValidComponent(entity, component.npcs)) return EntityTag::NPC;									// IF HAS NPC COMPONENT, return NPC
-	if (isValidComponent(entity, component.ammoPickups)) return EntityTag::AMMO;							// IF HAS AMMO PICKUP COMPONENT, return AMMO
-	if (isValidComponent(entity, component.healthPickups)) return EntityTag::HEALTH;						// IF HAS HEALTH PICKUP COMPONENT, return HEALTH
-	if (isValidComponent(entity, component.projectiles)) return EntityTag::PROJECTILE;						// IF HAS PROJECTILE COMPONENT, return PROJECTILE
-	if (isValidComponent(entity, component.endLevels)) return EntityTag::ENDLEVEL;							// IF HAS END LEVEL COMPONENT, return ENDLEVEL
+	const Signature tags = signatureOf(entity) & TAG_BITS;													// tag bits of entity, one load
+	if (tags & PC_BIT) return EntityTag::PC;																// IF HAS PLAYER COMPONENT, return PC
+	if (tags & NPC_BIT) return EntityTag::NPC;																// IF HAS NPC COMPONENT, return NPC
+	if (tags & AMMO_PICKUP_BIT) return EntityTag::AMMO;														// IF HAS AMMO PICKUP COMPONENT, return AMMO
+	if (tags & HEALTH_PICKUP_BIT) return EntityTag::HEALTH;													// IF HAS HEALTH PICKUP COMPONENT, return HEALTH
+	if (tags & PROJECTILE_BIT) return EntityTag::PROJECTILE;												// IF HAS PROJECTILE COMPONENT, return PROJECTILE
+	if (tags & END_LEVEL_BIT) return EntityTag::ENDLEVEL;													// IF HAS END LEVEL COMPONENT, return ENDLEVEL
 	return EntityTag::Unknown;																				// ELSE return Unknown
 }
 
 bool MyEngineSystem::isProjectileOwner(Entity entity, Entity other) {
-	if (getEntityTag(entity) == EntityTag::PROJECTILE) {													// IF ENTITY IS PROJECTILE
-		ProjectileTag& projectile = component.projectiles[entity];											// get projectile
-		if (other == projectile.owner) return true;															// IF OTHER IS OWNER, return true
+	if (hasAnyOf(entity, PROJECTILE_BIT)) {																	// IF ENTITY IS PROJECTILE
+		const ProjectileTag* projectile = component.projectiles.find(entity);								// find projectile, never inserts so the narrow phase can call this
+		if (projectile && other == projectile->owner) return true;											// IF OTHER IS OWNER, return true
 	}
-	else if (getEntityTag(other) == EntityTag::PROJECTILE) {												// IF OTHER IS PROJECTILE
-		ProjectileTag& projectile = component.projectiles[other];											// get projectile as other
-		if (entity == projectile.owner) return true;														// IF ENTITY IS OWNER, return true
+	else if (hasAnyOf(other, PROJECTILE_BIT)) {																// IF OTHER IS PROJECTILE
+		const ProjectileTag* projectile = component.projectiles.find(other);								// find projectile as other
+		if (projectile && entity == projectile->owner) return true;											// IF ENTITY IS OWNER, return true
 	}
 	return false;																							// ELSE return false
 }
 
+void MyEngineSystem::setEntityPosition(Entity entity, const Vector2f& position) {
+	Transform* transform = component.transforms.find(entity);												// find transform
+	if (!transform) return;																					// IF NO TRANSFORM, return
+	transform->position = position;																			// set position
+	transform->newPosition = position;																		// set new position
+	transform->previousPosition = position;																	// set previous position, no interpolation across the move
+	transform->startPosition = position;																	// set start position
+	if (const Collider* collider = component.colliders.find(entity))										// IF HAS COLLIDER
+		setEntityColliderRect(entity, position.x, position.y, collider->rect.w, collider->rect.h);			// move collider and broadphase entry
+}
+
 void MyEngineSystem::setEntityColliderRect(Entity entity, float posX, float posY, int width, int height) {
 	if (isValidComponent(entity, component.colliders)) {													// IF HAS COLLIDER
 		Collider& collider = component.colliders[entity];													// get collider
@@ -686,16 +1077,38 @@ void MyEngineSystem::setEntityColliderRect(Entity entity, float posX, float posY
 		collider.rect.y = roundToInt(posY);																	// set y
 		collider.rect.w = width;																			// set width
 		collider.rect.h = height;																			// set height
+		broadphase.update(entity, collider.rect);															// keep broadphase grid in sync
+	}
+}
+MyEngineSystem::Entity MyEngineSystem::createEntity()
+{
+	if (entityGenerations.empty()) entityGenerations.push_back(0);																		// reserve slot 0, handle 0 means no entity
+	std::uint32_t index = {};																											// slot for the new entity
+	if (!freeEntitySlots.empty()) {																										// IF A SLOT WAS RELEASED, reuse it
+		index = freeEntitySlots.back();																									// take last released slot
+		freeEntitySlots.pop_back();																										// remove from free list
 	}
+	else {																																// ELSE append a new slot
+		if (entityGenerations.size() > ENTITY_INDEX_MASK) throw EngineException("Entity limit reached", std::to_string(ENTITY_INDEX_MASK));	// IF OUT OF SLOTS, throw
+		index = std::uint32_t(entityGenerations.size());																				// next slot
+		entityGenerations.push_back(0);																									// first generation
+	}
+	Entity entity = makeEntity(index, entityGenerations[index]);																		// handle from slot and generation
+	activeEntities.insert(entity);																										// track as active
+	return entity;																														// return handle
 }
-template <typename T>
-bool MyEngineSystem::isValidComponent(Entity entity, ComponentMap<T>& comp) {
-	if (comp.find(entity) != comp.end())  return true;														// IF COMPONENT EXISTS, return true
-	return false;																							// return false
+
+void MyEngineSystem::releaseEntity(Entity entity)
+{
+	if (!isEntityAlive(entity)) return;																		// IF STALE OR ALREADY RELEASED, return
+	std::uint32_t index = entityIndex(entity);																// slot of entity
+	entityGenerations[index] = (entityGenerations[index] + 1) & ENTITY_GENERATION_MASK;						// bump generation, old handles stop matching
+	freeEntitySlots.push_back(index);																		// slot can be reused
 }
 
 void MyEngineSystem::flushDestroyedEntities()
 {
+	PROFILE_ZONE("flushDestroyedEntities");
 	if (entitiesToDestroy.empty()) return;																	// IF NO ENTITIES TO DESTROY, return
 	for (Entity entity : entitiesToDestroy) {																// FOR EACH ENTITY TO DESTROY, erase all components
 		component.transforms.erase(entity);
@@ -719,7 +1132,9 @@ void MyEngineSystem::flushDestroyedEntities()
 		component.audios.erase(entity);
 		component.projectiles.erase(entity);
 		component.scores.erase(entity);
+		broadphase.remove(entity);																			// remove from broadphase grid
 		activeEntities.erase(entity);																		// erase from active entities
+		releaseEntity(entity);																				// recycle entity slot
 	}
 	entitiesToDestroy.clear();																				// clear destruction list
 }
@@ -735,7 +1150,128 @@ void MyEngineSystem::clearLevelExcept(Entity player)
 		if (projectilePool->first == player) ++projectilePool;												// IF PLAYER, skip
 		else projectilePool = projectilePools.erase(projectilePool);										// ELSE ERASE
 	groundTiles.clear();																					// clear ground tiles
+	tileCellsDirty = true;																					// regroup tiles before next render
+	invalidateTileChunks(SDL_Rect{ 0, 0, int(worldWidth), int(worldHeight) });								// rebake every chunk
+	staticTiles.clear();																					// clear static collision layer
 	cameraPosition = Vector2f{ 0.0f, 0.0f };																// reset camera position
 	if (keeperHadPool && isValidComponent(player, component.players))										// IF PLAYER HAD POOL AND IS VALID PLAYER
 		initProjectilePool(player, DEFAULT_PROJECTILES_PER_OWNER);											// reinitialise projectile pool
+}
+
+void MyEngineSystem::setWorldDimensions(Uint32 width, Uint32 height)
+{
+	worldWidth = width; worldHeight = height;																// set world dimensions
+	tileCellsDirty = true;																					// tile cell grid depends on world size
+	staticTiles.resize(worldWidth, worldHeight);															// resize static collision layer
+	broadphase.resize(worldWidth, worldHeight);																// resize broadphase grid to the new world
+	for (auto colliderComp : component.colliders)															// FOR EACH COLLIDER
+		broadphase.update(colliderComp.first, colliderComp.second.rect);									// re-insert into broadphase grid
+}
+
+void MyEngineSystem::StaticTileLayer::resize(Uint32 worldWidth, Uint32 worldHeight)
+{
+	cols = int((worldWidth + TILE_SIZE - 1) / TILE_SIZE);													// columns to cover world width
+	rows = int((worldHeight + TILE_SIZE - 1) / TILE_SIZE);													// rows to cover world height
+	bits.assign((size_t(cols) * size_t(rows) + 63) / 64, 0);												// one bit per cell, all clear
+}
+
+void MyEngineSystem::StaticTileLayer::set(int col, int row)
+{
+	if (col < 0 || row < 0 || col >= cols || row >= rows) return;											// IF OUTSIDE LAYER, return
+	size_t index = size_t(row) * size_t(cols) + size_t(col);												// bit index
+	bits[index >> 6] |= std::uint64_t(1) << (index & 63);													// set bit
+}
+
+bool MyEngineSystem::StaticTileLayer::isSolid(int col, int row) const
+{
+	if (col < 0 || row < 0 || col >= cols || row >= rows) return false;										// IF OUTSIDE LAYER, not solid
+	size_t index = size_t(row) * size_t(cols) + size_t(col);												// bit index
+	return (bits[index >> 6] >> (index & 63)) & 1;															// test bit
+}
+
+int MyEngineSystem::StaticTileLayer::firstSolidColumn(const SDL_Rect& rect, bool leftToRight) const
+{
+	auto toCell = [](int value) { return (value >= 0) ? value / int(TILE_SIZE) : -((int(TILE_SIZE) - 1 - value) / int(TILE_SIZE)); };	// floor pixel to cell
+	int firstCol = toCell(rect.x), lastCol = toCell(rect.x + rect.w - 1);																// columns overlapped
+	int firstRow = toCell(rect.y), lastRow = toCell(rect.y + rect.h - 1);																// rows overlapped
+	for (int i = 0; i <= lastCol - firstCol; ++i) {																						// FOR EACH COLUMN IN SCAN ORDER
+		int col = leftToRight ? firstCol + i : lastCol - i;																				// get column
+		for (int row = firstRow; row <= lastRow; ++row)																					// FOR EACH ROW
+			if (isSolid(col, row)) return col;																							// IF SOLID, return column
+	}
+	return -1;																															// no solid cell
+}
+
+int MyEngineSystem::StaticTileLayer::firstSolidRow(const SDL_Rect& rect, bool topToBottom) const
+{
+	auto toCell = [](int value) { return (value >= 0) ? value / int(TILE_SIZE) : -((int(TILE_SIZE) - 1 - value) / int(TILE_SIZE)); };	// floor pixel to cell
+	int firstCol = toCell(rect.x), lastCol = toCell(rect.x + rect.w - 1);																// columns overlapped
+	int firstRow = toCell(rect.y), lastRow = toCell(rect.y + rect.h - 1);																// rows overlapped
+	for (int i = 0; i <= lastRow - firstRow; ++i) {																						// FOR EACH ROW IN SCAN ORDER
+		int row = topToBottom ? firstRow + i : lastRow - i;																				// get row
+		for (int col = firstCol; col <= lastCol; ++col)																					// FOR EACH COLUMN
+			if (isSolid(col, row)) return row;																							// IF SOLID, return row
+	}
+	return -1;																															// no solid cell
+}
+
+void MyEngineSystem::BroadphaseGrid::resize(Uint32 worldWidth, Uint32 worldHeight)
+{
+	cols = std::max(1, int((worldWidth + TILE_SIZE - 1) / TILE_SIZE));										// columns to cover world width, at least one
+	rows = std::max(1, int((worldHeight + TILE_SIZE - 1) / TILE_SIZE));										// rows to cover world height, at least one
+	cells.assign(size_t(cols) * size_t(rows), std::vector<Entity>());										// reset cells
+	occupied.clear();																						// forget previous cell ranges
+}
+
+SDL_Rect MyEngineSystem::BroadphaseGrid::cellRange(const SDL_Rect& rect) const
+{
+	auto toCell = [](int value, int count) { int cell = (value < 0) ? 0 : value / int(TILE_SIZE); return (cell >= count) ? count - 1 : cell; };	// pixel to clamped cell index
+	int right = rect.x + std::max(rect.w, 1) - 1, bottom = rect.y + std::max(rect.h, 1) - 1;											// inclusive right and bottom edges
+	return SDL_Rect{ toCell(rect.x, cols), toCell(rect.y, rows), toCell(right, cols), toCell(bottom, rows) };							// first and last cell on each axis
+}
+
+void MyEngineSystem::BroadphaseGrid::update(Entity entity, const SDL_Rect& rect)
+{
+	SDL_Rect range = cellRange(rect);																				// cells overlapped by rect
+	auto found = occupied.find(entity);																				// find current cell range
+	if (found != occupied.end()) {																					// IF ALREADY IN GRID
+		const SDL_Rect& current = found->second;																	// get current range
+		if (current.x == range.x && current.y == range.y && current.w == range.w && current.h == range.h) return;	// IF SAME CELLS, nothing to do
+		remove(entity);																								// ELSE remove from old cells
+	}
+	for (int y = range.y; y <= range.h; ++y)																		// FOR EACH ROW IN RANGE
+		for (int x = range.x; x <= range.w; ++x)																	// FOR EACH COLUMN IN RANGE
+			cells[size_t(y) * size_t(cols) + size_t(x)].push_back(entity);											// add entity to cell
+	occupied[entity] = range;																						// store cell range
+}
+
+void MyEngineSystem::BroadphaseGrid::remove(Entity entity)
+{
+	auto found = occupied.find(entity);																		// find current cell range
+	if (found == occupied.end()) return;																	// IF NOT IN GRID, return
+	const SDL_Rect range = found->second;																	// copy range
+	for (int y = range.y; y <= range.h; ++y) {																// FOR EACH ROW IN RANGE
+		for (int x = range.x; x <= range.w; ++x) {															// FOR EACH COLUMN IN RANGE
+			std::vector<Entity>& cell = cells[size_t(y) * size_t(cols) + size_t(x)];						// get cell
+			auto it = std::find(cell.begin(), cell.end(), entity);											// find entity in cell
+			if (it == cell.end()) continue;																	// IF NOT FOUND, skip
+			*it = cell.back();																				// swap with last
+			cell.pop_back();																				// and pop, order does not matter
+		}
+	}
+	occupied.erase(found);																					// forget cell range
+}
+
+void MyEngineSystem::BroadphaseGrid::query(const SDL_Rect& area, std::vector<Entity>& out) const
+{
+	out.clear();																							// clear results, keeps capacity
+	SDL_Rect range = cellRange(area);																		// cells overlapped by area
+	for (int y = range.y; y <= range.h; ++y)																// FOR EACH ROW IN RANGE
+		for (int x = range.x; x <= range.w; ++x) {															// FOR EACH COLUMN IN RANGE
+			const std::vector<Entity>& cell = cells[size_t(y) * size_t(cols) + size_t(x)];					// get cell
+			out.insert(out.end(), cell.begin(), cell.end());												// append cell entities
+		}
+	if (range.x == range.w && range.y == range.h) return;													// IF SINGLE CELL, no duplicates possible
+	std::sort(out.begin(), out.end());																		// sort so duplicates are adjacent
+	out.erase(std::unique(out.begin(), out.end()), out.end());												// remove entities spanning several cells
 }
\ No newline at end of file
@@ -1,10 +1,14 @@
 #ifndef __MY_ENGINE_H__
 #define __MY_ENGINE_H__
 #include "../ResourceManager.h"																									// For resource loading
+#include "ComponentPool.h"																										// For component storage
+#include "../Profiler.h"																										// For PROFILE_ZONE
+#include "../JobSystem.h"																										// For running systems on worker threads
 #include <unordered_map>																										// For component storage
 #include <utility>																												// for std::pair
 #include <unordered_set>																										// for unordered set
 #include <algorithm>																											// for std::stable_sort
+#include <functional>																											// for std::function
 
 static constexpr int DEFAULT_ENTITY_ID = { -1 };																				// Default entity ID
 static constexpr float DEFAULT_ENTITY_SCALE = { 1.0f }, DEFAULT_UNIT_SPEED = { 100 }, DEFAULT_PC_SPEED = { 200 },				// Default scales and speeds
@@ -14,15 +18,17 @@ STAT_CHANGE_COOLDOWN = { 250 }, BAR_HEIGHT = { 4 }, DEFAULT_UNIT_DAMAGE = { 10 }
 DEFAULT_NPC_SCORE_VALUE = { 10 }, DEFAULT_SFX_VOLUME = { 10 }, DEFAULT_FONT_SIZE = { 24 }, CAMERA_SMOOTHING_FACTOR = { 6 },		// default score value, sfx volume, font size and camera smoothing
 BACKGROUND_LAYER = { 0 }, GROUND_LAYER = { 1 }, OBJECT_LAYER = { 2 };															// default rendering layers
 static constexpr size_t DEFAULT_PROJECTILES_PER_OWNER = { 50 };																	// default projectile pool size per owner
+static constexpr int TILE_CHUNK_SIZE = { 32 };																					// tiles per side of a baked ground chunk
+static constexpr size_t JOB_CHUNK_SIZE = { 256 };																				// entities per parallel-for task
 
 class MyEngineSystem {
 	friend class XCube2Engine;																									// Friend class declaration
+	friend class EngineBench;																									// Benchmark drives the systems one at a time (bench/EngineBench.cpp)
+	friend class CollisionDispatchBench;																						// Benchmark times the collision response table (bench/CollisionDispatchBench.cpp)
 private:
 	MyEngineSystem();																											// Constructor
 	using Entity = std::uint32_t;																								// Entity type
-	enum class EntityTag { Unknown = 0, PC, NPC, AMMO, HEALTH, PROJECTILE, ENDLEVEL };											// Entity tags
-	template<typename T>																										// Template for component map
-	using ComponentMap = std::unordered_map<Entity, T>;																			// Component storage map
+	enum class EntityTag { Unknown = 0, PC, NPC, AMMO, HEALTH, PROJECTILE, ENDLEVEL, COUNT };											// Entity tags
 	struct PCTag {};																											// PC Tag
 	struct NPCTag {};																											// NPC Character Tag
 	struct AmmoPickupTag {};																									// Ammo Pickup Tag
@@ -30,7 +36,7 @@ private:
 	struct ProjectileTag { Entity owner = { 0 }; };																				// Projectile Tag with owner entity
 	struct EndLevelTag {};																										// End Level Tag
 	struct Transform {																											// A structure to hold transform data
-		Vector2f startPosition = {}, position = {}, newPosition = {};															// Positions					
+		Vector2f startPosition = {}, position = {}, newPosition = {}, previousPosition = {};									// Positions, previous is where the last step started
 		float scale = DEFAULT_ENTITY_SCALE;																						// Scale
 		int rotation = {}, layer = {};																							// Rotation and rendering layer
 		bool initialFlipH = false, flipH = false, active = true;																// Flipping and active state
@@ -39,6 +45,7 @@ private:
 	struct Sprite {																												// Sprite structure
 		SDL_Texture* texture = nullptr;																							// Texture pointer
 		int frameW = {}, frameH = {}, frameCount = 1, textureWidth = {}, textureHeight = {}, startFrame = {};					// Frame dimensions and count
+		int atlasX = {}, atlasY = {};																							// Sheet position inside texture, set when packed into an atlas
 		bool loop = true;																										// Looping flag
 		float scale = DEFAULT_ENTITY_SCALE;																						// Scale
 	};
@@ -64,76 +71,245 @@ private:
 	struct Ammo { int currentAmmo = DEFAULT_AMMO, maxAmmo = DEFAULT_MAX_AMMO; Uint32 lastFireTime = STAT_CHANGE_COOLDOWN; };	// Ammo structure
 	struct Input { float x = {}, y = {}; };																						// Input structure
 	struct ScoreValue { int amount = {}; };																						// Score value structure
+	struct Dying { bool isDying = false; };																						// Dying state structure
+	using Signature = ComponentSignature;																						// Component signature, one bit per pool
+	enum SignatureBit : Signature {																								// Signature bit of each component pool
+		TRANSFORM_BIT = 1u << 0,																								// Transform
+		VELOCITY_BIT = 1u << 1,																									// Velocity
+		SPRITE_BIT = 1u << 2,																									// Sprite
+		ANIMATION_BIT = 1u << 3,																								// Animation
+		PC_BIT = 1u << 4,																										// PCTag
+		NPC_BIT = 1u << 5,																										// NPCTag
+		AMMO_PICKUP_BIT = 1u << 6,																								// AmmoPickupTag
+		HEALTH_PICKUP_BIT = 1u << 7,																							// HealthPickupTag
+		PROJECTILE_BIT = 1u << 8,																								// ProjectileTag
+		END_LEVEL_BIT = 1u << 9,																								// EndLevelTag
+		HEALTH_BIT = 1u << 10,																									// Health
+		COLLIDER_BIT = 1u << 11,																								// Collider
+		DAMAGE_BIT = 1u << 12,																									// Damage
+		SPEED_BIT = 1u << 13,																									// Speed
+		AMMO_BIT = 1u << 14,																									// Ammo
+		HEALTH_BAR_BIT = 1u << 15,																								// HealthBar
+		INPUT_BIT = 1u << 16,																									// Input
+		ANIMATION_STATE_BIT = 1u << 17,																							// AnimationState
+		DYING_BIT = 1u << 18,																									// Dying
+		AUDIO_BIT = 1u << 19,																									// Audio
+		SCORE_VALUE_BIT = 1u << 20,																								// ScoreValue
+		TAG_BITS = PC_BIT | NPC_BIT | AMMO_PICKUP_BIT | HEALTH_PICKUP_BIT | PROJECTILE_BIT | END_LEVEL_BIT						// Bits of the entity tag pools
+	};
 	struct Component																											// Component storage struct
 	{
-		ComponentMap<Transform> transforms;																						// Transform Component storage
-		ComponentMap<Velocity> velocities;																						// Velocity Component storage
-		ComponentMap<Sprite> sprites;																							// Sprite Component storage
-		ComponentMap<Animation> animations;																						// Animation Component storage
-		ComponentMap<PCTag> players;																							// Player Tag Component storage
-		ComponentMap<NPCTag> npcs;																								// NPC Tag Component storage
-		ComponentMap<AmmoPickupTag> ammoPickups;																				// Ammo Pickup Tag Component storage
-		ComponentMap<HealthPickupTag> healthPickups;																			// Health Pickup Tag
-		ComponentMap<ProjectileTag> projectiles;																				// Projectile Component storage
-		ComponentMap<EndLevelTag> endLevels;																					// End Level Tag Component storage
-		ComponentMap<Health> healths;																							// Health Component storage
-		ComponentMap<Collider> colliders;																						// Collider Component storage
-		ComponentMap<Damage> damages;																							// Damage Component storage
-		ComponentMap<Speed> speeds;																								// Speed Component storage
-		ComponentMap<Ammo> ammos;																								// Ammo Component storage
-		ComponentMap<HealthBar> healthBars;																						// HealthBar Component storage
-		ComponentMap<Input> inputs;																								// Input Component storage
-		ComponentMap<AnimationState> animationStates;																			// AnimationState Component storage
-		ComponentMap<bool>dying;																								// Dying state Component storage
-		ComponentMap<Audio> audios;																								// Audio Component storage
-		ComponentMap<ScoreValue> scores;																						// Score Component storage
+		ComponentPool<Transform> transforms;																					// Transform Component storage
+		ComponentPool<Velocity> velocities;																						// Velocity Component storage
+		ComponentPool<Sprite> sprites;																							// Sprite Component storage
+		ComponentPool<Animation> animations;																					// Animation Component storage
+		ComponentPool<PCTag> players;																							// Player Tag Component storage
+		ComponentPool<NPCTag> npcs;																								// NPC Tag Component storage
+		ComponentPool<AmmoPickupTag> ammoPickups;																				// Ammo Pickup Tag Component storage
+		ComponentPool<HealthPickupTag> healthPickups;																			// Health Pickup Tag
+		ComponentPool<ProjectileTag> projectiles;																				// Projectile Component storage
+		ComponentPool<EndLevelTag> endLevels;																					// End Level Tag Component storage
+		ComponentPool<Health> healths;																							// Health Component storage
+		ComponentPool<Collider> colliders;																						// Collider Component storage
+		ComponentPool<Damage> damages;																							// Damage Component storage
+		ComponentPool<Speed> speeds;																							// Speed Component storage
+		ComponentPool<Ammo> ammos;																								// Ammo Component storage
+		ComponentPool<HealthBar> healthBars;																					// HealthBar Component storage
+		ComponentPool<Input> inputs;																							// Input Component storage
+		ComponentPool<AnimationState> animationStates;																			// AnimationState Component storage
+		ComponentPool<Dying> dying;																								// Dying state Component storage
+		ComponentPool<Audio> audios;																							// Audio Component storage
+		ComponentPool<ScoreValue> scores;																						// Score Component storage
+		std::vector<Signature> signatures;																						// Signature per entity, kept up to date by the bound pools
+		Component() {																											// Constructor, binds each pool to its signature bit
+			transforms.bindSignature(&signatures, TRANSFORM_BIT);
+			velocities.bindSignature(&signatures, VELOCITY_BIT);
+			sprites.bindSignature(&signatures, SPRITE_BIT);
+			animations.bindSignature(&signatures, ANIMATION_BIT);
+			players.bindSignature(&signatures, PC_BIT);
+			npcs.bindSignature(&signatures, NPC_BIT);
+			ammoPickups.bindSignature(&signatures, AMMO_PICKUP_BIT);
+			healthPickups.bindSignature(&signatures, HEALTH_PICKUP_BIT);
+			projectiles.bindSignature(&signatures, PROJECTILE_BIT);
+			endLevels.bindSignature(&signatures, END_LEVEL_BIT);
+			healths.bindSignature(&signatures, HEALTH_BIT);
+			colliders.bindSignature(&signatures, COLLIDER_BIT);
+			damages.bindSignature(&signatures, DAMAGE_BIT);
+			speeds.bindSignature(&signatures, SPEED_BIT);
+			ammos.bindSignature(&signatures, AMMO_BIT);
+			healthBars.bindSignature(&signatures, HEALTH_BAR_BIT);
+			inputs.bindSignature(&signatures, INPUT_BIT);
+			animationStates.bindSignature(&signatures, ANIMATION_STATE_BIT);
+			dying.bindSignature(&signatures, DYING_BIT);
+			audios.bindSignature(&signatures, AUDIO_BIT);
+			scores.bindSignature(&signatures, SCORE_VALUE_BIT);
+		}
+		Component(const Component&) = delete;																					// Pools point at signatures, so no copies
+		Component& operator=(const Component&) = delete;																		// No copy assignment
+		// pool lookup by component type, used by get<T>() and view<Ts...>()
+		ComponentPool<Transform>& pool(Transform*) { return transforms; }
+		ComponentPool<Velocity>& pool(Velocity*) { return velocities; }
+		ComponentPool<Sprite>& pool(Sprite*) { return sprites; }
+		ComponentPool<Animation>& pool(Animation*) { return animations; }
+		ComponentPool<PCTag>& pool(PCTag*) { return players; }
+		ComponentPool<NPCTag>& pool(NPCTag*) { return npcs; }
+		ComponentPool<AmmoPickupTag>& pool(AmmoPickupTag*) { return ammoPickups; }
+		ComponentPool<HealthPickupTag>& pool(HealthPickupTag*) { return healthPickups; }
+		ComponentPool<ProjectileTag>& pool(ProjectileTag*) { return projectiles; }
+		ComponentPool<EndLevelTag>& pool(EndLevelTag*) { return endLevels; }
+		ComponentPool<Health>& pool(Health*) { return healths; }
+		ComponentPool<Collider>& pool(Collider*) { return colliders; }
+		ComponentPool<Damage>& pool(Damage*) { return damages; }
+		ComponentPool<Speed>& pool(Speed*) { return speeds; }
+		ComponentPool<Ammo>& pool(Ammo*) { return ammos; }
+		ComponentPool<HealthBar>& pool(HealthBar*) { return healthBars; }
+		ComponentPool<Input>& pool(Input*) { return inputs; }
+		ComponentPool<AnimationState>& pool(AnimationState*) { return animationStates; }
+		ComponentPool<Dying>& pool(Dying*) { return dying; }
+		ComponentPool<Audio>& pool(Audio*) { return audios; }
+		ComponentPool<ScoreValue>& pool(ScoreValue*) { return scores; }
+		template<typename T>
+		ComponentPool<T>& get() { return pool(static_cast<T*>(nullptr)); }														// Pool storing components of type T
+		template<typename... Ts>
+		ComponentView<Entity, Ts...> view() { return ComponentView<Entity, Ts...>(get<Ts>()...); }								// Query entities having all of Ts
 	};
 	Component component;
+	struct BroadphaseGrid {																										// Uniform grid broadphase with TILE_SIZE cells
+		int cols = 1, rows = 1;																									// Grid dimensions in cells
+		std::vector<std::vector<Entity>> cells = std::vector<std::vector<Entity>>(1);											// Entities overlapping each cell
+		std::unordered_map<Entity, SDL_Rect> occupied;																			// Cell range per entity (x/y first cell, w/h last cell)
+		void resize(Uint32 worldWidth, Uint32 worldHeight);																		// Resize grid to cover the world and drop all entries
+		void update(Entity entity, const SDL_Rect& rect);																		// Insert entity or move it to the cells overlapping rect
+		void remove(Entity entity);																								// Remove entity from grid
+		void query(const SDL_Rect& area, std::vector<Entity>& out) const;														// Collect unique entities overlapping area
+		SDL_Rect cellRange(const SDL_Rect& rect) const;																			// Cell range covered by rect, clamped to grid
+	};
+	struct StaticTileLayer {																									// Static collision layer, one bit per TILE_SIZE cell
+		int cols = {}, rows = {};																								// Layer dimensions in cells
+		std::vector<std::uint64_t> bits;																						// Packed solid flags, row major
+		void resize(Uint32 worldWidth, Uint32 worldHeight);																		// Resize layer to cover the world and clear it
+		void clear() { std::fill(bits.begin(), bits.end(), 0); }																// Clear all solid cells
+		void set(int col, int row);																								// Mark cell as solid
+		bool isSolid(int col, int row) const;																					// Is cell solid, cells outside the layer are not
+		int firstSolidColumn(const SDL_Rect& rect, bool leftToRight) const;														// First column overlapped by rect holding a solid cell, -1 if none
+		int firstSolidRow(const SDL_Rect& rect, bool topToBottom) const;														// First row overlapped by rect holding a solid cell, -1 if none
+	};
+	StaticTileLayer staticTiles;																								// Walls, resolved by cell lookup instead of as entities
+	BroadphaseGrid broadphase;																									// Collider broadphase
+	struct CollisionContact { Entity primary = {}, other = {}; };																// Narrow phase contact, other is 0 when primary hit a wall
+	struct CollisionResult { Vector2f position; Velocity velocity; SDL_Rect rect = {}; Uint32 pairsTested = {}; };				// Where the narrow phase left one mover
+	struct CollisionChunk {																										// Narrow phase buffers of one chunk of movers
+		std::vector<CollisionContact> contacts;																					// Contacts in mover order, replayed by applyCollisionContacts
+		std::vector<Entity> candidates;																							// Reused broadphase query results
+		std::vector<std::pair<Entity, SDL_Rect>> obstacles;																		// Reused narrow phase obstacle list
+	};
+	std::vector<Entity> collisionMovers;																						// Active moving colliders this step, in view order
+	std::vector<CollisionResult> collisionResults;																				// Narrow phase output, parallel to collisionMovers
+	std::vector<Entity> separationCandidates;																					// Reused broadphase query results of the write back pass
+	std::vector<CollisionChunk> collisionChunks;																				// One per JOB_CHUNK_SIZE movers, kept across steps for their capacity
+	using CollisionHandler = void (MyEngineSystem::*)(Entity first, Entity second);												// Collision response, first entity has the row tag
+	struct CollisionResponse { CollisionHandler handler = nullptr; bool swapped = false; };										// Handler and whether the pair must be swapped to match it
+	static constexpr int TAG_COUNT = { int(EntityTag::COUNT) };																	// Number of entity tags
+	CollisionResponse collisionResponses[TAG_COUNT][TAG_COUNT];																	// Collision response table indexed by (tagA, tagB)
+	static std::uint64_t pairKey(Entity first, Entity second) { return (std::uint64_t(std::min(first, second)) << 32) | std::max(first, second); }	// Order independent pair key, smaller entity in the high bits
+	std::vector<std::uint64_t> contactPairs;																					// Pair keys of this step's entity contacts, sorted and unique
+	std::vector<bool> contactPairResolved;																						// Parallel to contactPairs, set once the pair's response has run
 	std::map<std::string, Sprite> loadedSprites;																				// Loaded sprite data keyed by name
+	struct SpriteSource { std::string file; SDL_Color transparent; bool packed = false; };										// Image a sprite was loaded from
+	std::map<std::string, SpriteSource> spriteSources;																			// Sprite sources keyed by sprite name, used by buildSpriteAtlas
+	static Sprite makeSprite(int frameW, int frameH, int frames, int startFrame, bool loop, float scale);						// Sprite with frame data but no texture yet
+	void addSprite(const std::string& name, SDL_Texture* texture, Sprite sprite, const SpriteSource& source);					// Attach texture and store sprite under name
+	void onTextureReloaded(SDL_Texture* oldTexture, SDL_Texture* newTexture);													// Repoint sprites and rebake tiles after a hot reload
 	std::map<std::string, Mix_Chunk*> loadedSounds;																				// Loaded sounds
 	std::unordered_map<Entity, std::vector<Entity>> projectilePools;															// owner pool of projectile entity IDs
 	struct Tile { int x = {}, y = {}; std::string spriteName; };																// Tile structure with position and sprite name
 	std::vector<Tile> groundTiles;																								// A list of ground tiles
+	std::vector<Uint32> tileCellStart;																							// Offset into tileCellOrder for each TILE_SIZE cell, one extra entry at the end
+	std::vector<Uint32> tileCellOrder;																							// groundTiles indices grouped by cell, insertion order kept within a cell
+	int tileCols = {}, tileRows = {};																							// Tile cell grid dimensions
+	bool tileCellsDirty = true;																									// Rebuild tile cells before the next renderTiles
+	struct TileChunk { SDL_Texture* texture = nullptr; bool dirty = true; };													// Ground tiles baked into a render target, rebaked when dirty
+	std::vector<TileChunk> tileChunks;																							// Chunks of TILE_CHUNK_SIZE cells per side in row order
+	Uint32 seenRenderTargetResets = {};																							// GraphicsEngine render target resets already rebaked for
+	int chunkCols = {}, chunkRows = {};																							// Chunk grid dimensions
 	std::unordered_set<Entity> activeEntities;																					// currently active entities
 	std::unordered_set<Entity> entitiesToDestroy;																				// entities queued for destruction
+	std::vector<std::uint32_t> entityGenerations;																				// current generation per entity slot, slot 0 is the null entity
+	std::vector<std::uint32_t> freeEntitySlots;																					// slots released by flushDestroyedEntities, reused first
+	Uint32 collisionPairsTested = {};																							// candidate pairs checked by the last collisionSystem, for profiling
 	Uint32 now = {};																											// Current time in milliseconds
+	bool headless = false;																										// set by XCube2Engine, sprites keep no texture and sounds are not loaded
+	std::shared_ptr<JobSystem> jobs;																							// set by XCube2Engine, systems run serially without one
+	void parallelFor(size_t count, const std::function<void(size_t, size_t)>& body);											// Run body over chunks of [0, count) on the job workers and wait
+	double simulatedTime = {};																									// seconds simulated so far, the clock in headless mode so runs repeat exactly
 	Uint32 score = {};																											// Global score
 	Vector2f cameraPosition = {};																								// camera world position 
 	float cameraSmoothing = CAMERA_SMOOTHING_FACTOR;																			// camera smoothing factor
 	Uint32 currentLevel = {}, levelsCount = {};																					// current level index and total levels
 	bool levelChanging = {}, gameCompleted = {};																				// level changing and game completed flags
+	bool levelClearPending = {};																								// clear level once systems have finished this frame
+	Entity levelClearKeeper = {};																								// entity kept when the pending level clear runs
 	Uint32 worldWidth = {}, worldHeight = {};																					// world width and height in pixels 
 	// PRIVATE METHODS
 	void flushDestroyedEntities();																								// actually remove enqueued entities
+	void releaseEntity(Entity entity);																							// bump slot generation and return it to the free list
 	void destroyEntity(Entity entity) { entitiesToDestroy.insert(entity); }														// Destroy entity
 	void movementSystem(Component& com, float deltaTime = deltaTime);															// Movement system
 	void animationSystem(Component& com, float deltaTime = deltaTime);															// Animation system
 	void updateAnimationStates(Component& com, float deltaTime = deltaTime);													// Update animation states
 	void renderHealthBar(std::shared_ptr<GraphicsEngine> gfx, Entity entity, int posX, int posY, int width, int height);		// Render health bar
 	void renderTiles(std::shared_ptr<GraphicsEngine>);																			// Render ground tiles
+	void buildTileCells();																										// Group ground tiles by cell so only visible cells are drawn
+	void drawTileCells(std::shared_ptr<GraphicsEngine> gfx, int firstCol, int firstRow, int lastCol, int lastRow, const Vector2f& origin);	// Queue every tile in a cell range, origin is the world position drawn at 0,0
+	bool bakeTileChunk(std::shared_ptr<GraphicsEngine> gfx, int chunkCol, int chunkRow);										// Draw a chunk's tiles into its render target, false if it has none
+	void invalidateTileChunks(const SDL_Rect& area);																			// Mark chunks overlapping a world area for rebaking
+	void releaseTileChunks();																									// Destroy chunk render targets
 	void collisionSystem(Component& com, float deltaTime = deltaTime);															// Collision system
 	void aiSystem(Component& com, Entity playerEntity, float deltaTime = deltaTime);											// AI system
 	void changeEntityHealth(Entity entity, int amount);																			// Change entity health
-	void processCollisionEntities(Component& com, Entity primary, Entity other, Uint32 now);									// Process collision between two entities
+	void narrowPhase(Component& com, size_t begin, size_t end, CollisionChunk& chunk);											// Resolve movers [begin, end) against colliders as they were at the start of the step, only reads components
+	bool overlapsMover(Entity entity, const SDL_Rect& rect);																	// Does rect overlap another moving collider that blocks entity, as the colliders are now
+	void collectContactPairs();																									// Sort this step's entity contacts into contactPairs, one entry per pair
+	void applyCollisionContacts(const std::vector<CollisionContact>& contacts);													// Apply collision responses in contact order
+	void processCollisionEntities(Entity primary, Entity other);																// Resolve collision between two entities, once per step for pairs in contactPairs
+	void setCollisionResponse(EntityTag first, EntityTag second, CollisionHandler handler);										// Set handler for a tag pair, both orders
+	void buildCollisionResponses();																								// Fill collision response table
+	void onEndLevelReached(Entity trigger, Entity player);																		// Collision response, player reached end level trigger
+	void onHealthPickup(Entity pickup, Entity other);																			// Collision response, health pickup touched by non NPC
+	void applyDamage(Entity attacker, Entity victim);																			// Collision response, attacker damages victim
 	void playAudio(const std::string& name, int volume = -1, int loops = 0, int channel = -1);									// Play audio
 	void handleDeath(Entity entity, Health& health);																			// Respawn entity
 	void deactivateProjectile(Entity proj);																						// deactivate projectile
 	void updateCamera(std::shared_ptr<GraphicsEngine> gfx, float deltaTime = deltaTime);										// update camera position
+	float interpolation = 1.0f;																									// fraction of a step rendering is past the last update, set by render
+	Vector2f renderPosition(const Transform& transform) const;																	// position blended between previous and current step
 	void increaseAmmo(Entity attacker, Entity victim);																			// increase ammo for owner
 	void processPendingDeaths();																								// Check dying entities and finalize when anim done
 	void finaliseDeath(Entity entity);																							// Perform the actual death completion work
 	bool isProjectileOwner(Entity entity, Entity other);																		// check if projectile owner
 	void setEntityColliderRect(Entity entity, float posX, float posY, int width, int height);									// set entity collider rectangle
 	template<typename T>																										// Template for getting valid component
-	bool isValidComponent(Entity entity, ComponentMap<T>& comp);																// check if entity has valid component
+	bool isValidComponent(Entity entity, const ComponentPool<T>& comp) const { return comp.has(entity); }						// check if entity has valid component
+	template<typename... Ts>																									// Template for multi-component queries
+	ComponentView<Entity, Ts...> view() { return component.view<Ts...>(); }														// Entities having all of Ts, e.g. view<Transform, Velocity, Collider>().each(...)
+	Signature signatureOf(Entity entity) const { return entityIndex(entity) < component.signatures.size() && isEntityAlive(entity) ? component.signatures[entityIndex(entity)] : 0; }	// Signature of entity, 0 if it has no components or is stale
+	bool hasAnyOf(Entity entity, Signature bits) const { return (signatureOf(entity) & bits) != 0; }							// Does entity have any of the components in bits
+	bool hasAllOf(Entity entity, Signature bits) const { return (signatureOf(entity) & bits) == bits; }							// Does entity have all of the components in bits
 public:
 	~MyEngineSystem();																											// Destructor
-	Entity createEntity() { static Entity next{}; Entity id = next++; activeEntities.insert(id); return id; };					// Create a new entity ID
-	void loadSprite(const std::string& name, const std::string& filename, int frameW, int frameH, int frames, int startFrame = 0, bool loop = false, float scale = 1, SDL_Color transparent = { 255,255,255,255 });	// Load sprite from file
+	Entity createEntity();																										// Create a new entity, reusing a free slot if there is one
+	bool isEntityAlive(Entity entity) const { return entityIndex(entity) != 0 && entityIndex(entity) < entityGenerations.size() && entityGenerations[entityIndex(entity)] == entityGeneration(entity); }	// Is handle current, false once destroyed
+	void loadSprite(const std::string& name, const std::string& filename, int frameW, int frameH, int frames, int startFrame = 0, bool loop = false, float scale = 1, SDL_Color transparent = { 255,255,255,255 });	// Load sprite from file, the decoded sheet is kept until buildSpriteAtlas packs it
+	void loadSpriteAsync(const std::string& name, const std::string& filename, int frameW, int frameH, int frames, int startFrame = 0, bool loop = false, float scale = 1, SDL_Color transparent = { 255,255,255,255 });	// Load sprite on a worker thread, available once ResourceManager::processAsyncLoads uploads it, the decoded sheet is kept for buildSpriteAtlas
+	void unloadSprite(const std::string& name);																					// Forget sprite and release its texture, call once no entity draws it
+	void buildSpriteAtlas(int pageSize = 1024);																					// Pack every loaded sprite sheet into shared atlas textures
 	void loadSound(const std::string& name, const std::string& filename);														// Load sound
-	void render(std::shared_ptr<GraphicsEngine> gfx);																			// Render all entities
+	void loadSoundAsync(const std::string& name, const std::string& filename);													// Load sound on a worker thread
+	void render(std::shared_ptr<GraphicsEngine> gfx, float interpolation = 1.0f, float frameTime = deltaTime);					// Render all entities, interpolation of a step past the last update, frameTime seconds after the previous render
 	void update(float deltaTime = deltaTime, int playerEntityId = 1);															// Update all systems
 	void addGroundTile(const std::string& spriteName, int x, int y);															// Add ground tile
+	void addStaticTile(const std::string& spriteName, int x, int y);															// Add solid tile to the static collision layer
+	bool isStaticTileInRect(const SDL_Rect& rect) const { return staticTiles.firstSolidColumn(rect, true) >= 0; }				// Does rect overlap any solid tile
 	void fireProjectile(Entity owner, const Vector2f& startPos, const Vector2f& targetPos);										// fire a projectile from owner
 	void setEntityInput(Entity entity, float x, float y);																		// Set entity input
 	void initProjectilePool(Entity owner, size_t poolSize = DEFAULT_PROJECTILES_PER_OWNER);										// initialise projectile pool for owner
@@ -146,16 +322,16 @@ public:
 	void addComponentAmmoPickupTag(Entity entity) { component.ammoPickups[entity] = AmmoPickupTag(); }							// Set ammo pickup tag
 	void addComponentHealthPickupTag(Entity entity) { component.healthPickups[entity] = HealthPickupTag(); }					// Set health pickup tag
 	void addComponentEndLevelTag(Entity entity) { component.endLevels[entity] = EndLevelTag(); }								// Set end level tag	
-	void addComponentTransform(Entity entity, const Vector2f& position, float scale = DEFAULT_ENTITY_SCALE, int rotation = 0, int layer = 0, bool initialFlipH = false) { component.transforms[entity] = Transform{ position, position, position, scale, rotation, layer, initialFlipH, false, true }; }
+	void addComponentTransform(Entity entity, const Vector2f& position, float scale = DEFAULT_ENTITY_SCALE, int rotation = 0, int layer = 0, bool initialFlipH = false) { component.transforms[entity] = Transform{ position, position, position, position, scale, rotation, layer, initialFlipH, false, true }; }
 	void addComponentVelocity(Entity entity, float x = {}, float y = {}) { component.velocities[entity] = Velocity{ x, y }; }	// Set velocity	
 	void addComponentSpeed(Entity entity, float speed = DEFAULT_UNIT_SPEED) { component.speeds[entity] = Speed{ speed }; }		// Set speed
-	void addComponentCollider(Entity entity, float x, float y, int width = TILE_SIZE, int height = TILE_SIZE) { component.colliders[entity] = Collider{ SDL_Rect{ roundToInt(x), roundToInt(y), width, height } }; }	// Set collider
+	void addComponentCollider(Entity entity, float x, float y, int width = TILE_SIZE, int height = TILE_SIZE) { component.colliders[entity] = Collider{ SDL_Rect{ roundToInt(x), roundToInt(y), width, height } }; broadphase.update(entity, component.colliders[entity].rect); }	// Set collider
 	void addComponentHealth(Entity entity, int currentHealth = DEFAULT_MAX_HEALTH, int maxHealth = DEFAULT_MAX_HEALTH) { component.healths[entity] = Health{ currentHealth, maxHealth }; }	// Set health
 	void addComponentHealthBar(Entity entity) { component.healthBars[entity] = HealthBar(); }									// Set health bar
 	void addComponentAmmo(Entity entity, int currentAmmo, int maxAmmo = DEFAULT_MAX_AMMO) { component.ammos[entity] = Ammo{ currentAmmo, maxAmmo }; }
 	void addComponentDamage(Entity entity, int amount = DEFAULT_UNIT_DAMAGE) { component.damages[entity] = Damage{ amount }; }	// Set damage
 	void addComponentInput(Entity entity) { component.inputs[entity] = Input{}; }												// Set input
-	void addComponentDying(Entity entity) { component.dying[entity] = false; }													// Set dying state
+	void addComponentDying(Entity entity) { component.dying[entity] = Dying{ false }; }											// Set dying state
 	void addComponentIdleAnimations(Entity entity, std::string = "", std::string = "", std::string = "");						// Set idle animations
 	void addComponentWalkAnimations(Entity entity, std::string = "", std::string = "", std::string = "");						// Set walk animations
 	void addComponentDeathAnimations(Entity entity, std::string = "", std::string = "", std::string = "");						// Set death animations
@@ -166,7 +342,10 @@ public:
 	Uint32 getCurrentLevel() const { return currentLevel; }																		// get current level index
 	bool isLevelChanging() const { return levelChanging; }																		// is level changing
 	bool isGameCompleted() const { return gameCompleted; }																		// is game completed
+	bool isHeadless() const { return headless; }																				// running without graphics and audio
 	int getNPCCount() const { return static_cast<int>(component.npcs.size()); };												// get current NPC count
+	int getEntityCount() const { return entityGenerations.empty() ? 0 : int(entityGenerations.size() - 1 - freeEntitySlots.size()); }	// get live entity count
+	Uint32 getCollisionPairsTested() const { return collisionPairsTested; }														// get candidate pairs checked by the last update
 	int getScore() const { return score; };																						// Get current score
 	EntityTag getEntityTag(Entity entity);																						// Get entity tag
 	Vector2f MyEngineSystem::getCameraPosition() const { return cameraPosition; };												// get camera position
@@ -174,10 +353,10 @@ public:
 	int getEntityHealth(Entity entity) { return (isValidComponent(entity, component.healths)) ? component.healths[entity].currentHealth : -1; }	// Get entity health
 	Vector2f getEntityPosition(Entity entity) { return (isValidComponent(entity, component.transforms)) ? component.transforms[entity].position : Vector2f{}; }	// Get entity position
 	SDL_Rect getEntityColliderRect(Entity entity) { return (isValidComponent(entity, component.colliders)) ? component.colliders[entity].rect : SDL_Rect{}; }	// Get entity collider rectangle
-	std::vector<Entity> getAllEndLevelTriggers() { std::vector<Entity> triggers; for (const auto& pair : component.endLevels)  triggers.push_back(pair.first); return triggers; } // get all end level triggers
+	std::vector<Entity> getAllEndLevelTriggers() { return component.endLevels.entities(); }										// get all end level triggers
 	// SETTERS	
-	void setEntityPosition(Entity entity, const Vector2f& position) { if (isValidComponent(entity, component.transforms)) { component.transforms[entity].position = position; component.transforms[entity].newPosition = position; component.transforms[entity].startPosition = position; } } // Set entity position
-	void setWorldDimensions(Uint32 width, Uint32 height) { worldWidth = width; worldHeight = height; }							// set world dimensions
+	void setEntityPosition(Entity entity, const Vector2f& position);															// Set entity position, moving its collider with it
+	void setWorldDimensions(Uint32 width, Uint32 height);																		// set world dimensions
 	void setLevelsCount(Uint32 count) { levelsCount = count; }																	// set total number of levels
 	void setLevelChanging(bool value) { levelChanging = value; }																// set level changing flag
 };
@@ -0,0 +1,181 @@
+#define SDL_MAIN_HANDLED
+#include <SDL.h>
+#include <SDL_image.h>
+#include <SDL_mixer.h>
+
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <cctype>
+#include <string>
+#include <vector>
+
+#include "../src/engine/AssetArchive.h"
+
+/**
+* Cooks images and sounds into one archive that ResourceManager::loadArchive() maps
+*
+* usage: AssetCooker [-r frequency] [-c channels] output.pak files...
+*
+* Files ending in .wav are converted to PCM in the mixer format,
+* which defaults to what AudioEngine opens (44100 Hz, MIX_DEFAULT_FORMAT, MIX_DEFAULT_CHANNELS).
+* Everything else is decoded with SDL_image into RGBA32 pixels.
+* Assets are looked up by the name they are given here, so pass them
+* the way the game loads them, e.g. res/ground.png
+*/
+
+struct CookedAsset {
+	AssetEntry entry;
+	std::vector<Uint8> data;
+};
+
+static bool endsWith(const std::string& text, const std::string& suffix) {
+	if (text.size() < suffix.size())
+		return false;
+
+	for (size_t i = 0; i < suffix.size(); ++i)
+		if (tolower(text[text.size() - suffix.size() + i]) != suffix[i])
+			return false;
+	return true;
+}
+
+static bool cookImage(const char* file, CookedAsset& asset) {
+	SDL_Surface* loaded = IMG_Load(file);
+	if (nullptr == loaded) {
+		std::printf("Failed to load image %s: %s\n", file, IMG_GetError());
+		return false;
+	}
+
+	SDL_Surface* rgba = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_RGBA32, 0);
+	SDL_FreeSurface(loaded);
+	if (nullptr == rgba) {
+		std::printf("Failed to convert image %s: %s\n", file, SDL_GetError());
+		return false;
+	}
+
+	// rows are stored tightly packed, the surface pitch may be padded
+	size_t rowSize = (size_t)rgba->w * 4;
+	asset.entry.type = ASSET_IMAGE;
+	asset.entry.width = (Uint32)rgba->w;
+	asset.entry.height = (Uint32)rgba->h;
+	asset.data.resize(rowSize * rgba->h);
+	SDL_LockSurface(rgba);
+	for (int row = 0; row < rgba->h; ++row)
+		std::memcpy(&asset.data[row * rowSize], (const Uint8*)rgba->pixels + row * rgba->pitch, rowSize);
+	SDL_UnlockSurface(rgba);
+	SDL_FreeSurface(rgba);
+	return true;
+}
+
+static bool cookSound(const char* file, int frequency, Uint16 format, int channels, CookedAsset& asset) {
+	SDL_AudioSpec spec;
+	Uint8* buffer = nullptr;
+	Uint32 length = 0;
+	if (nullptr == SDL_LoadWAV(file, &spec, &buffer, &length)) {
+		std::printf("Failed to load sound %s: %s\n", file, SDL_GetError());
+		return false;
+	}
+
+	SDL_AudioCVT cvt;
+	int conversion = SDL_BuildAudioCVT(&cvt, spec.format, spec.channels, spec.freq, format, (Uint8)channels, frequency);
+	if (conversion < 0) {
+		std::printf("Cannot convert sound %s: %s\n", file, SDL_GetError());
+		SDL_FreeWAV(buffer);
+		return false;
+	}
+
+	asset.entry.type = ASSET_SOUND;
+	asset.entry.frequency = (Uint32)frequency;
+	asset.entry.format = format;
+	asset.entry.channels = (Uint16)channels;
+	if (0 == conversion) {
+		asset.data.assign(buffer, buffer + length);
+	}
+	else {
+		cvt.len = (int)length;
+		asset.data.resize((size_t)length * cvt.len_mult);
+		std::memcpy(asset.data.data(), buffer, length);
+		cvt.buf = asset.data.data();
+		SDL_ConvertAudio(&cvt);
+		asset.data.resize((size_t)cvt.len_cvt);
+	}
+	SDL_FreeWAV(buffer);
+	return true;
+}
+
+int main(int argc, char* argv[]) {
+	int frequency = 44100, channels = MIX_DEFAULT_CHANNELS;
+	int arg = 1;
+	for (; arg + 1 < argc && argv[arg][0] == '-'; arg += 2) {
+		if (std::strcmp(argv[arg], "-r") == 0)
+			frequency = std::atoi(argv[arg + 1]);
+		else if (std::strcmp(argv[arg], "-c") == 0)
+			channels = std::atoi(argv[arg + 1]);
+		else
+			break;
+	}
+
+	if (argc - arg < 2 || frequency <= 0 || channels <= 0) {
+		std::printf("usage: AssetCooker [-r frequency] [-c channels] output.pak files...\n");
+		return 1;
+	}
+
+	const char* output = argv[arg++];
+	if ((IMG_Init(IMG_INIT_PNG) & IMG_INIT_PNG) != IMG_INIT_PNG)
+		std::printf("SDL_image PNG support missing: %s\n", IMG_GetError());
+
+	std::vector<CookedAsset> assets;
+	for (; arg < argc; ++arg) {
+		const char* file = argv[arg];
+		if (std::strlen(file) >= (size_t)ASSET_NAME_LENGTH) {
+			std::printf("Name too long for archive: %s\n", file);
+			return 1;
+		}
+
+		CookedAsset asset;
+		std::memset(&asset.entry, 0, sizeof(asset.entry));
+		std::strncpy(asset.entry.name, file, ASSET_NAME_LENGTH - 1);
+		bool cooked = endsWith(file, ".wav") ? cookSound(file, frequency, MIX_DEFAULT_FORMAT, channels, asset) : cookImage(file, asset);
+		if (!cooked)
+			return 1;
+		asset.entry.size = asset.data.size();
+		assets.push_back(std::move(asset));
+	}
+
+	// blobs follow the entry table, each aligned so pixels and samples can be used in place
+	Uint64 offset = sizeof(AssetArchiveHeader) + assets.size() * sizeof(AssetEntry);
+	for (CookedAsset& asset : assets) {
+		offset = (offset + ASSET_ARCHIVE_ALIGNMENT - 1) / ASSET_ARCHIVE_ALIGNMENT * ASSET_ARCHIVE_ALIGNMENT;
+		asset.entry.offset = offset;
+		offset += asset.entry.size;
+	}
+
+	FILE* out = std::fopen(output, "wb");
+	if (nullptr == out) {
+		std::printf("Failed to open %s for writing\n", output);
+		return 1;
+	}
+
+	AssetArchiveHeader header = { ASSET_ARCHIVE_MAGIC, ASSET_ARCHIVE_VERSION, (Uint32)assets.size(), 0 };
+	bool written = std::fwrite(&header, sizeof(header), 1, out) == 1;
+	for (const CookedAsset& asset : assets)
+		written = written && std::fwrite(&asset.entry, sizeof(asset.entry), 1, out) == 1;
+
+	const char padding[ASSET_ARCHIVE_ALIGNMENT] = {};
+	Uint64 position = sizeof(AssetArchiveHeader) + assets.size() * sizeof(AssetEntry);
+	for (const CookedAsset& asset : assets) {
+		written = written && std::fwrite(padding, 1, (size_t)(asset.entry.offset - position), out) == asset.entry.offset - position;
+		written = written && (asset.data.empty() || std::fwrite(asset.data.data(), 1, asset.data.size(), out) == asset.data.size());
+		position = asset.entry.offset + asset.entry.size;
+	}
+	written = (std::fclose(out) == 0) && written;
+
+	if (!written) {
+		std::printf("Failed to write %s\n", output);
+		return 1;
+	}
+
+	std::printf("Cooked %u assets into %s (%llu bytes)\n", (unsigned)assets.size(), output, (unsigned long long)position);
+	IMG_Quit();
+	return 0;
+}